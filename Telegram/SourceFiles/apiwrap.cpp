@@ -95,6 +95,7 @@ namespace {
 constexpr auto kSaveCloudDraftTimeout = 1000;
 
 constexpr auto kSmallDelayMs = 5;
+constexpr auto kMessageDataResolveDelay = crl::time(20);
 constexpr auto kReadFeaturedSetsTimeout = crl::time(1000);
 constexpr auto kFileLoaderQueueStopTimeout = crl::time(5000);
 constexpr auto kStickersByEmojiInvalidateTimeout = crl::time(6 * 1000);
@@ -103,6 +104,9 @@ constexpr auto kDialogsFirstLoad = 20;
 constexpr auto kDialogsPerPage = 500;
 constexpr auto kStatsSessionKillTimeout = 10 * crl::time(1000);
 
+// The shared media overview starts from the end of the list.
+constexpr auto kLastSharedMediaId = ServerMaxMsgId - 1;
+
 using PhotoFileLocationId = Data::PhotoFileLocationId;
 using DocumentFileLocationId = Data::DocumentFileLocationId;
 using UpdatedFileReferences = Data::UpdatedFileReferences;
@@ -162,7 +166,7 @@ TimeId UnixtimeFromMsgId(mtpMsgId msgId) {
 ApiWrap::ApiWrap(not_null<Main::Session*> session)
 : MTP::Sender(&session->account().mtp())
 , _session(session)
-, _messageDataResolveDelayed([=] { resolveMessageDatas(); })
+, _messageDataResolveTimer([=] { resolveMessageDatas(); })
 , _webPagesTimer([=] { resolveWebPages(); })
 , _draftsSaveTimer([=] { saveDraftsToCloud(); })
 , _featuredSetsReadTimer([=] { readFeaturedSets(); })
@@ -574,8 +578,9 @@ void ApiWrap::requestMessageData(
 	if (done) {
 		requests.callbacks.push_back(std::move(done));
 	}
-	if (!requests.requestId) {
-		_messageDataResolveDelayed.call();
+	if (!requests.requestId && !_messageDataResolveTimer.isActive()) {
+		// Collect the ids requested during a few frames of scrolling.
+		_messageDataResolveTimer.callOnce(kMessageDataResolveDelay);
 	}
 }
 
@@ -2804,6 +2809,7 @@ void ApiWrap::requestStickers(TimeId now) {
 }
 
 void ApiWrap::requestMasks(TimeId now) {
+	_session->data().stickers().readLocalMasks();
 	if (!_session->data().stickers().masksUpdateNeeded(now)
 		|| _masksUpdateRequest) {
 		return;
@@ -2854,6 +2860,9 @@ void ApiWrap::requestCustomEmoji(TimeId now) {
 void ApiWrap::requestRecentStickers(
 		std::optional<TimeId> now,
 		bool attached) {
+	if (attached) {
+		_session->data().stickers().readLocalMasks();
+	}
 	const auto needed = !now
 		? true
 		: attached
@@ -2981,6 +2990,7 @@ void ApiWrap::requestFeaturedEmoji(TimeId now) {
 }
 
 void ApiWrap::requestSavedGifs(TimeId now) {
+	_session->data().stickers().readLocalSavedGifs();
 	if (!_session->data().stickers().savedGifsUpdateNeeded(now)
 		|| _savedGifsUpdateRequest) {
 		return;
@@ -3281,12 +3291,33 @@ void ApiWrap::requestSharedMedia(
 
 	const auto history = _session->data().history(peer);
 	auto &histories = history->owner().histories();
+	const auto cached = !topicRootId
+		&& !monoforumPeerId
+		&& (messageId == kLastSharedMediaId);
+	const auto cacheKey = SharedMediaCacheKey{ peer, type };
+	if (cached && !_sharedMediaCached.contains(cacheKey)) {
+		_sharedMediaCached.emplace(cacheKey);
+		histories.readCachedSharedMedia(peer, type, [=](
+				const QVector<MTPMessage> &messages) {
+			// Skip it if the fresh slice was already received.
+			if (_sharedMediaRequests.contains(key)) {
+				sharedMediaCachedDone(peer, type, messages);
+			}
+		});
+	}
 	const auto requestType = Data::Histories::RequestType::History;
 	histories.sendRequest(history, requestType, [=](Fn<void()> finish) {
 		return request(
 			std::move(*prepared)
 		).done([=](const Api::SearchRequestResult &result) {
 			_sharedMediaRequests.remove(key);
+			if (cached) {
+				sharedMediaValidateCached(peer, type, result);
+				peer->owner().histories().writeCachedSharedMedia(
+					peer,
+					type,
+					result);
+			}
 			auto parsed = Api::ParseSearchResult(
 				peer,
 				type,
@@ -3302,12 +3333,133 @@ void ApiWrap::requestSharedMedia(
 			finish();
 		}).fail([=] {
 			_sharedMediaRequests.remove(key);
+			if (cached) {
+				sharedMediaCachedFailed(peer, type);
+			}
 			finish();
 		}).send();
 	});
 	_sharedMediaRequests.emplace(key);
 }
 
+void ApiWrap::sharedMediaCachedDone(
+		not_null<PeerData*> peer,
+		SharedMediaType type,
+		const QVector<MTPMessage> &messages) {
+	auto &owner = peer->owner();
+	const auto history = owner.history(peer);
+	auto created = std::vector<MsgId>();
+	auto ids = std::vector<MsgId>();
+	ids.reserve(messages.size());
+	for (const auto &message : messages) {
+		const auto id = IdFromMessage(message);
+		const auto existing = (owner.message(peer, id) != nullptr);
+
+		// Passing a message from the history cache to addNewMessage()
+		// would confirm it as fresh, then it won't be dropped if deleted.
+		const auto item = history->isCachedSliceItem(id)
+			? owner.message(peer, id)
+			: owner.addNewMessage(
+				message,
+				MessageFlags(),
+				NewMessageType::Existing);
+		if (!item) {
+			continue;
+		} else if (!existing) {
+			created.push_back(id);
+		}
+		if (item->sharedMediaTypes().test(type)) {
+			ids.push_back(id);
+		}
+	}
+	const auto key = SharedMediaCacheKey{ peer, type };
+	auto &cached = _sharedMediaCached[key];
+	cached.created = std::move(created);
+	if (ids.empty()) {
+		return;
+	}
+	cached.shown = true;
+	ranges::sort(ids);
+
+	// The range has to reach the last id to be shown as the last slice,
+	// so it claims that nothing newer exists until the fresh slice comes.
+	// If the request fails the claim is dropped in sharedMediaCachedFailed.
+	const auto noSkipRange = MsgRange{ ids.front(), kLastSharedMediaId };
+	_session->storage().add(Storage::SharedMediaAddSlice(
+		peer->id,
+		MsgId(),
+		PeerId(),
+		type,
+		std::move(ids),
+		noSkipRange));
+}
+
+void ApiWrap::sharedMediaValidateCached(
+		not_null<PeerData*> peer,
+		SharedMediaType type,
+		const MTPmessages_Messages &fresh) {
+	const auto key = SharedMediaCacheKey{ peer, type };
+	const auto i = _sharedMediaCached.find(key);
+	if (i == end(_sharedMediaCached)) {
+		return;
+	}
+	i->second.shown = false;
+	const auto taken = base::take(i->second.created);
+	if (taken.empty()) {
+		return;
+	}
+	const auto created = base::flat_set<MsgId>{ begin(taken), end(taken) };
+	const auto messages = fresh.match([](
+			const MTPDmessages_messagesNotModified &) {
+		return QVector<MTPMessage>();
+	}, [](const auto &data) {
+		return data.vmessages().v;
+	});
+	auto &owner = peer->owner();
+	auto freshIds = base::flat_set<MsgId>();
+	auto minFreshId = std::numeric_limits<MsgId>::max();
+	for (const auto &message : messages) {
+		const auto id = IdFromMessage(message);
+		if (created.contains(id)) {
+			owner.updateEditedMessage(message);
+		}
+		freshIds.emplace(id);
+		accumulate_min(minFreshId, id);
+	}
+
+	// Cached messages inside the fresh slice range that the server didn't
+	// return were deleted or changed while we were offline.
+	for (const auto id : created) {
+		if (freshIds.contains(id)
+			|| (!messages.isEmpty() && id < minFreshId)) {
+			continue;
+		} else if (const auto item = owner.message(peer, id)) {
+			if (item->mainView()) {
+				item->removeFromSharedMediaIndex();
+			} else {
+				item->destroy();
+			}
+		}
+	}
+}
+
+void ApiWrap::sharedMediaCachedFailed(
+		not_null<PeerData*> peer,
+		SharedMediaType type) {
+	const auto key = SharedMediaCacheKey{ peer, type };
+	const auto i = _sharedMediaCached.find(key);
+	if (i == end(_sharedMediaCached) || !i->second.shown) {
+		return;
+	}
+	i->second.shown = false;
+
+	// The cached slice wasn't confirmed, so it shouldn't stop the
+	// newer messages from being requested later.
+	_session->storage().remove(Storage::SharedMediaRemoveAll(
+		peer->id,
+		type));
+}
+
 void ApiWrap::sharedMediaDone(
 		not_null<PeerData*> peer,
 		MsgId topicRootId,
@@ -535,6 +535,17 @@ private:
 		PeerId monoforumPeerId,
 		SharedMediaType type,
 		Api::SearchResult &&parsed);
+	void sharedMediaCachedDone(
+		not_null<PeerData*> peer,
+		SharedMediaType type,
+		const QVector<MTPMessage> &messages);
+	void sharedMediaValidateCached(
+		not_null<PeerData*> peer,
+		SharedMediaType type,
+		const MTPmessages_Messages &fresh);
+	void sharedMediaCachedFailed(
+		not_null<PeerData*> peer,
+		SharedMediaType type);
 	void globalMediaDone(
 		SharedMediaType type,
 		FullMsgId messageId,
@@ -613,7 +624,7 @@ private:
 	base::flat_map<
 		not_null<ChannelData*>,
 		MessageDataRequests> _channelMessageDataRequests;
-	SingleQueuedInvokation _messageDataResolveDelayed;
+	base::Timer _messageDataResolveTimer;
 
 	using PeerRequests = base::flat_map<PeerData*, mtpRequestId>;
 	PeerRequests _fullPeerRequests;
@@ -692,6 +703,17 @@ private:
 	};
 	base::flat_set<SharedMediaRequest> _sharedMediaRequests;
 
+	// Ids of the messages created from the cached last shared media slices,
+	// they are refreshed or destroyed when the fresh slice is received.
+	using SharedMediaCacheKey = std::pair<
+		not_null<PeerData*>,
+		SharedMediaType>;
+	struct SharedMediaCached {
+		std::vector<MsgId> created;
+		bool shown = false;
+	};
+	base::flat_map<SharedMediaCacheKey, SharedMediaCached> _sharedMediaCached;
+
 	struct HistoryRequest {
 		not_null<PeerData*> peer;
 		MsgId aroundId = 0;
@@ -173,32 +173,26 @@ void WriteLocalCache(const QString &id, const LangPackData &data) {
 	return key.toLower().trimmed();
 }
 
+// Emoji already in the result, so that the duplicates are skipped
+// without searching through the whole result for each entry.
+using AddedEmoji = std::unordered_set<EmojiPtr>;
+
 void AppendFoundEmoji(
 		std::vector<Result> &result,
+		AddedEmoji &added,
 		const QString &label,
 		const std::vector<LangPackEmoji> &list) {
-	// It is important that the 'result' won't relocate while inserting.
 	result.reserve(result.size() + list.size());
-	const auto alreadyBegin = begin(result);
-	const auto alreadyEnd = alreadyBegin + result.size();
-
-	auto &&add = ranges::views::all(
-		list
-	) | ranges::views::filter([&](const LangPackEmoji &entry) {
-		const auto i = ranges::find(
-			alreadyBegin,
-			alreadyEnd,
-			entry.emoji,
-			&Result::emoji);
-		return (i == alreadyEnd);
-	}) | ranges::views::transform([&](const LangPackEmoji &entry) {
-		return Result{ entry.emoji, label, entry.text };
-	});
-	result.insert(end(result), add.begin(), add.end());
+	for (const auto &entry : list) {
+		if (added.emplace(entry.emoji).second) {
+			result.push_back({ entry.emoji, label, entry.text });
+		}
+	}
 }
 
 void AppendLegacySuggestions(
 		std::vector<Result> &result,
+		AddedEmoji &added,
 		const QString &query) {
 	const auto badSuggestionChar = [](QChar ch) {
 		return (ch < 'a' || ch > 'z')
@@ -214,31 +208,17 @@ void AppendLegacySuggestions(
 
 	const auto suggestions = GetSuggestions(QStringToUTF16(query));
 
-	// It is important that the 'result' won't relocate while inserting.
 	result.reserve(result.size() + suggestions.size());
-	const auto alreadyBegin = begin(result);
-	const auto alreadyEnd = alreadyBegin + result.size();
-
-	auto &&add = ranges::views::all(
-		suggestions
-	) | ranges::views::transform([](const Suggestion &suggestion) {
-		return Result{
-			Find(QStringFromUTF16(suggestion.emoji())),
-			QStringFromUTF16(suggestion.label()),
-			QStringFromUTF16(suggestion.replacement())
-		};
-	}) | ranges::views::filter([&](const Result &entry) {
-		const auto i = entry.emoji
-			? ranges::find(
-				alreadyBegin,
-				alreadyEnd,
-				entry.emoji,
-				&Result::emoji)
-			: alreadyEnd;
-		return (entry.emoji != nullptr)
-			&& (i == alreadyEnd);
-	});
-	result.insert(end(result), add.begin(), add.end());
+	for (const auto &suggestion : suggestions) {
+		const auto emoji = Find(QStringFromUTF16(suggestion.emoji()));
+		if (emoji && added.emplace(emoji).second) {
+			result.push_back({
+				emoji,
+				QStringFromUTF16(suggestion.label()),
+				QStringFromUTF16(suggestion.replacement())
+			});
+		}
+	}
 }
 
 void ApplyDifference(
@@ -489,8 +469,9 @@ std::vector<Result> EmojiKeywords::LangPack::query(
 	});
 
 	auto result = std::vector<Result>();
+	auto added = AddedEmoji();
 	for (const auto &[key, list] : chosen) {
-		AppendFoundEmoji(result, key, list);
+		AppendFoundEmoji(result, added, key, list);
 	}
 	return result;
 }
@@ -613,30 +594,18 @@ std::vector<Result> EmojiKeywords::query(
 		return {};
 	}
 	auto result = std::vector<Result>();
+	auto added = AddedEmoji();
 	for (const auto &[language, item] : _data) {
-		const auto list = item->query(normalized, exact);
-
-		// It is important that the 'result' won't relocate while inserting.
+		auto list = item->query(normalized, exact);
 		result.reserve(result.size() + list.size());
-		const auto alreadyBegin = begin(result);
-		const auto alreadyEnd = alreadyBegin + result.size();
-
-		auto &&add = ranges::views::all(
-			list
-		) | ranges::views::filter([&](Result entry) {
-			// In each item->query() result the list has no duplicates.
-			// So we need to check only for duplicates between queries.
-			const auto i = ranges::find(
-				alreadyBegin,
-				alreadyEnd,
-				entry.emoji,
-				&Result::emoji);
-			return (i == alreadyEnd);
-		});
-		result.insert(end(result), add.begin(), add.end());
+		for (auto &entry : list) {
+			if (added.emplace(entry.emoji).second) {
+				result.push_back(std::move(entry));
+			}
+		}
 	}
 	if (!exact) {
-		AppendLegacySuggestions(result, query);
+		AppendLegacySuggestions(result, added, query);
 	}
 	return result;
 }
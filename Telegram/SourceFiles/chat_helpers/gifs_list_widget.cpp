@@ -65,6 +65,7 @@ void AddGifAction(
 		return;
 	}
 	auto &data = document->owner();
+	data.stickers().readLocalSavedGifs();
 	const auto index = data.stickers().savedGifs().indexOf(document);
 	const auto saved = (index >= 0);
 	const auto text = (saved
@@ -116,6 +117,7 @@ GifsListWidget::GifsListWidget(
 	setMouseTracking(true);
 	setAttribute(Qt::WA_OpaquePaintEvent);
 
+	session().data().stickers().readLocalSavedGifs();
 	setupSearch();
 
 	_inlineRequestTimer.setSingleShot(true);
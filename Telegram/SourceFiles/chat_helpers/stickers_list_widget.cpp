@@ -230,7 +230,9 @@ StickersListWidget::StickersListWidget(
 		setAttribute(Qt::WA_OpaquePaintEvent);
 	}
 
-	if (!_isMasks && !_isEffects) {
+	if (_isMasks) {
+		session().data().stickers().readLocalMasks();
+	} else if (!_isEffects) {
 		setupSearch();
 	}
 
@@ -13,6 +13,7 @@ https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
 #include "data/data_message_reactions.h"
 #include "data/data_session.h"
 #include "data/data_download_manager.h"
+#include "data/data_memory_governor.h"
 #include "base/battery_saving.h"
 #include "base/event_filter.h"
 #include "base/invoke_queued.h"
@@ -27,6 +28,7 @@ https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
 #include "core/sandbox.h"
 #include "core/local_url_handlers.h"
 #include "core/launcher.h"
+#include "core/startup_trace.h"
 #include "core/ui_integration.h"
 #include "chat_helpers/emoji_keywords.h"
 #include "chat_helpers/stickers_emoji_image_loader.h"
@@ -150,11 +152,13 @@ struct Application::Private {
 Application::Application()
 : QObject()
 , _private(std::make_unique<Private>())
+, _startupTrace(std::make_unique<StartupTrace>())
 , _platformIntegration(Platform::Integration::Create())
 , _batterySaving(std::make_unique<base::BatterySaving>())
 , _mediaDevices(std::make_unique<Webrtc::Environment>())
 , _databases(std::make_unique<Storage::Databases>())
 , _animationsManager(std::make_unique<Ui::Animations::Manager>())
+, _memoryGovernor(std::make_unique<Data::MemoryGovernor>())
 , _clearEmojiImageLoaderTimer([=] { clearEmojiSourceImages(); })
 , _audio(std::make_unique<Media::Audio::Instance>())
 , _fallbackProductionConfig(
@@ -260,8 +264,10 @@ void Application::run() {
 	// Depends on notifications settings.
 	_notifications = std::make_unique<Window::Notifications::System>();
 
+	_startupTrace->stage(u"local storage"_q);
 	startLocalStorage();
 
+	_startupTrace->stage(u"fonts"_q);
 	style::SetCustomFont(settings().customFontFamily());
 	style::internal::StartFonts();
 
@@ -284,6 +290,7 @@ void Application::run() {
 		return;
 	}
 
+	_startupTrace->stage(u"style"_q);
 	_translator = std::make_unique<Lang::Translator>();
 	QCoreApplication::instance()->installTranslator(_translator.get());
 
@@ -291,11 +298,14 @@ void Application::run() {
 	Ui::Accessible::Init();
 	Ui::InitTextOptions();
 	Ui::StartCachedCorners();
+	_startupTrace->stage(u"emoji"_q);
 	Ui::Emoji::Init();
 	Ui::PreloadTextSpoilerMask();
+	_startupTrace->stage(u"shortcuts"_q);
 	startShortcuts();
 	startEmojiImageLoader();
 	startSystemDarkModeViewer();
+	_startupTrace->stage(u"media player"_q);
 	Media::Player::start(_audio.get());
 
 	if (MediaControlsManager::Supported()) {
@@ -323,7 +333,12 @@ void Application::run() {
 	DEBUG_LOG(("Application Info: starting app..."));
 
 	// Create mime database, so it won't be slow later.
-	QMimeDatabase().mimeTypeForName(u"text/plain"_q);
+	crl::async([done = _startupTrace->asyncStage(u"mime database"_q)] {
+		QMimeDatabase().mimeTypeForName(u"text/plain"_q);
+		done();
+	});
+
+	_startupTrace->stage(u"window"_q);
 
 	// Check now to avoid re-entrance later.
 	[[maybe_unused]] const auto ivSupported = Iv::ShowButton();
@@ -377,9 +392,12 @@ void Application::run() {
 
 	DEBUG_LOG(("Application Info: window created..."));
 
+	_startupTrace->stage(u"domain"_q);
 	startDomain();
+	_startupTrace->stage(u"tray"_q);
 	startTray();
 
+	_startupTrace->stage(u"first show"_q);
 	_lastActivePrimaryWindow->firstShow();
 
 	startMediaView();
@@ -387,6 +405,9 @@ void Application::run() {
 	DEBUG_LOG(("Application Info: showing."));
 	_lastActivePrimaryWindow->finishFirstShow();
 
+	_startupTrace->finish();
+	LOG(("Startup Trace:\n%1").arg(_startupTrace->serialize()));
+
 	if (!_lastActivePrimaryWindow->locked() && cStartToSettings()) {
 		_lastActivePrimaryWindow->showSettings();
 	}
@@ -831,9 +852,11 @@ void Application::startLocalStorage() {
 void Application::startEmojiImageLoader() {
 	_emojiImageLoader.with([
 		source = prepareEmojiSourceImages(),
-		large = settings().largeEmoji()
+		large = settings().largeEmoji(),
+		done = _startupTrace->asyncStage(u"emoji images"_q)
 	](Stickers::EmojiImageLoader &loader) mutable {
 		loader.init(std::move(source), large);
+		done();
 	});
 
 	settings().largeEmojiChanges(
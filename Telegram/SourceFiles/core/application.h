@@ -91,6 +91,7 @@ class CloudManager;
 namespace Data {
 struct CloudTheme;
 class DownloadManager;
+class MemoryGovernor;
 } // namespace Data
 
 namespace Stickers {
@@ -114,6 +115,7 @@ namespace Core {
 struct LocalUrlHandler;
 class Settings;
 class Tray;
+class StartupTrace;
 
 enum class LaunchState {
 	Running,
@@ -156,12 +158,18 @@ public:
 	[[nodiscard]] Data::DownloadManager &downloadManager() const {
 		return *_downloadManager;
 	}
+	[[nodiscard]] Data::MemoryGovernor &memoryGovernor() const {
+		return *_memoryGovernor;
+	}
 	[[nodiscard]] Tray &tray() const {
 		return *_tray;
 	}
 	[[nodiscard]] base::BatterySaving &batterySaving() const {
 		return *_batterySaving;
 	}
+	[[nodiscard]] const StartupTrace &startupTrace() const {
+		return *_startupTrace;
+	}
 
 	// Windows interface.
 	bool hasActiveWindow(not_null<Main::Session*> session) const;
@@ -402,12 +410,16 @@ private:
 	// Some fields are just moved from the declaration.
 	struct Private;
 	const std::unique_ptr<Private> _private;
+	const std::unique_ptr<StartupTrace> _startupTrace;
 	const std::unique_ptr<Platform::Integration> _platformIntegration;
 	const std::unique_ptr<base::BatterySaving> _batterySaving;
 	const std::unique_ptr<Webrtc::Environment> _mediaDevices;
 
 	const std::unique_ptr<Storage::Databases> _databases;
 	const std::unique_ptr<Ui::Animations::Manager> _animationsManager;
+
+	// Should be destroyed after everything holding decoded media.
+	const std::unique_ptr<Data::MemoryGovernor> _memoryGovernor;
 	crl::object_on_queue<Stickers::EmojiImageLoader> _emojiImageLoader;
 	base::Timer _clearEmojiImageLoaderTimer;
 	const std::unique_ptr<Media::Audio::Instance> _audio;
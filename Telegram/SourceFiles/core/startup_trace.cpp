@@ -0,0 +1,84 @@
+/*
+This file is part of Telegram Desktop,
+the official desktop application for the Telegram messaging service.
+
+For license and copyright information please follow this link:
+https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
+*/
+#include "core/startup_trace.h"
+
+#include "storage/details/storage_file_utilities.h"
+
+namespace Core {
+
+StartupTrace::StartupTrace()
+: _created(crl::now()) {
+}
+
+void StartupTrace::stage(const QString &name) {
+	const auto now = crl::now();
+	finishCurrent(now);
+	_current = StartupStage{ .name = name, .started = now - _created };
+	_currentBytesRead = Storage::details::FilesBytesRead();
+}
+
+void StartupTrace::finish() {
+	finishCurrent(crl::now());
+}
+
+void StartupTrace::finishCurrent(crl::time now) {
+	if (!_current) {
+		return;
+	}
+	auto stage = *base::take(_current);
+	stage.duration = now - _created - stage.started;
+	stage.bytesRead = Storage::details::FilesBytesRead()
+		- _currentBytesRead;
+	_stages.push_back(std::move(stage));
+}
+
+Fn<void()> StartupTrace::asyncStage(const QString &name) {
+	const auto started = crl::now() - _created;
+	return [=, weak = base::make_weak(this)] {
+		const auto finished = crl::now();
+		crl::on_main(weak, [=] {
+			_stages.push_back({
+				.name = name,
+				.started = started,
+				.duration = finished - _created - started,
+				.async = true,
+			});
+		});
+	};
+}
+
+QString StartupTrace::serialize() const {
+	auto sorted = _stages;
+	ranges::stable_sort(sorted, ranges::less(), &StartupStage::started);
+
+	auto result = QStringList();
+	result.reserve(sorted.size());
+	for (const auto &stage : sorted) {
+		result.push_back(u"%1 ms +%2 ms: %3%4%5"_q
+			.arg(stage.started)
+			.arg(stage.duration)
+			.arg(stage.name)
+			.arg(stage.bytesRead
+				? u", %1 KB read"_q.arg(stage.bytesRead / 1024)
+				: QString())
+			.arg(stage.async ? u", async"_q : QString()));
+	}
+	return result.join('\n');
+}
+
+bool StartupTrace::dump(const QString &path) const {
+	auto f = QFile(path);
+	if (!f.open(QIODevice::WriteOnly)) {
+		LOG(("Startup Error: could not open '%1' for writing.").arg(path));
+		return false;
+	}
+	f.write(serialize().toUtf8());
+	return true;
+}
+
+} // namespace Core
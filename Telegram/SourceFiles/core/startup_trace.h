@@ -0,0 +1,50 @@
+/*
+This file is part of Telegram Desktop,
+the official desktop application for the Telegram messaging service.
+
+For license and copyright information please follow this link:
+https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
+*/
+#pragma once
+
+#include "base/weak_ptr.h"
+
+namespace Core {
+
+struct StartupStage {
+	QString name;
+	crl::time started = 0; // Since the trace creation.
+	crl::time duration = 0;
+	int64 bytesRead = 0;
+	bool async = false;
+};
+
+// Timings of the launch stages, all methods are called on the main thread.
+class StartupTrace final : public base::has_weak_ptr {
+public:
+	StartupTrace();
+
+	// Finishes the previous stage and starts the next one.
+	void stage(const QString &name);
+	void finish();
+
+	// The result should be called on the worker thread when it is done.
+	[[nodiscard]] Fn<void()> asyncStage(const QString &name);
+
+	[[nodiscard]] const std::vector<StartupStage> &stages() const {
+		return _stages;
+	}
+	[[nodiscard]] QString serialize() const;
+	bool dump(const QString &path) const;
+
+private:
+	void finishCurrent(crl::time now);
+
+	const crl::time _created = 0;
+	std::vector<StartupStage> _stages;
+	std::optional<StartupStage> _current;
+	int64 _currentBytesRead = 0;
+
+};
+
+} // namespace Core
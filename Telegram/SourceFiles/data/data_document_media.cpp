@@ -155,7 +155,14 @@ bool VideoPreviewState::loaded() const {
 }
 
 DocumentMedia::DocumentMedia(not_null<DocumentData*> owner)
-: _owner(owner) {
+: _owner(owner)
+, _memory({
+	.category = (owner->sticker()
+		? MemoryCategory::Stickers
+		: MemoryCategory::Images),
+	.bytes = [=] { return imagesMemoryBytes(); },
+	.unload = [=](MemoryPriority priority) { unloadImages(priority); },
+}) {
 }
 
 // NB! Right now DocumentMedia can outlive Main::Session!
@@ -174,6 +181,7 @@ void DocumentMedia::goodThumbnailWanted() {
 Image *DocumentMedia::goodThumbnail() const {
 	Expects((_flags & Flag::GoodThumbnailWanted) != 0);
 
+	_memory.touch();
 	if (!_goodThumbnail) {
 		ReadOrGenerateThumbnail(_owner);
 	}
@@ -185,10 +193,12 @@ void DocumentMedia::setGoodThumbnail(QImage thumbnail) {
 		return;
 	}
 	_goodThumbnail = std::make_unique<Image>(std::move(thumbnail));
+	_memory.touch();
 	_owner->session().notifyDownloaderTaskFinished();
 }
 
 Image *DocumentMedia::thumbnailInline() const {
+	_memory.touch();
 	if (!_inlineThumbnail && !_owner->inlineThumbnailIsPath()) {
 		const auto bytes = _owner->inlineThumbnailBytes();
 		if (!bytes.isEmpty()) {
@@ -217,6 +227,7 @@ const QPainterPath &DocumentMedia::thumbnailPath() const {
 }
 
 Image *DocumentMedia::thumbnail() const {
+	_memory.touch();
 	return _thumbnail.get();
 }
 
@@ -236,6 +247,7 @@ QSize DocumentMedia::thumbnailSize() const {
 
 void DocumentMedia::setThumbnail(QImage thumbnail) {
 	_thumbnail = std::make_unique<Image>(std::move(thumbnail));
+	_memory.touch();
 	_owner->session().notifyDownloaderTaskFinished();
 }
 
@@ -387,6 +399,7 @@ void DocumentMedia::checkStickerSmall() {
 }
 
 Image *DocumentMedia::getStickerLarge() {
+	_memory.touch();
 	checkStickerLarge();
 	return _sticker.get();
 }
@@ -396,9 +409,41 @@ Image *DocumentMedia::getStickerSmall() {
 	if ((data && data->isAnimated()) || thumbnailEnoughForSticker()) {
 		return thumbnail();
 	}
+	_memory.touch();
+	if (!_sticker && loaded()) {
+		// Could be unloaded by the memory governor.
+		checkStickerLarge();
+	}
 	return _sticker.get();
 }
 
+int64 DocumentMedia::imagesMemoryBytes() const {
+	const auto bytes = [](const std::unique_ptr<Image> &image) {
+		return image ? image->memoryBytes() : int64(0);
+	};
+	return bytes(_goodThumbnail)
+		+ bytes(_inlineThumbnail)
+		+ bytes(_thumbnail)
+		+ bytes(_sticker);
+}
+
+void DocumentMedia::unloadImages(MemoryPriority priority) {
+	// Everything except the thumbnail is restored on the next access,
+	// the thumbnail is requested by the views only once.
+	_inlineThumbnail = nullptr;
+	if (_sticker && loaded()) {
+		_sticker = nullptr;
+	}
+	if (_thumbnail) {
+		_thumbnail->forgetCache();
+	}
+	if (priority == MemoryPriority::RecentlyClosed) {
+		_goodThumbnail = nullptr;
+	} else if (_goodThumbnail) {
+		_goodThumbnail->forgetCache();
+	}
+}
+
 void DocumentMedia::checkStickerLarge(not_null<FileLoader*> loader) {
 	if (_sticker || !_owner->sticker()) {
 		return;
@@ -8,6 +8,7 @@ https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
 #pragma once
 
 #include "base/flags.h"
+#include "data/data_memory_governor.h"
 
 class Image;
 class FileLoader;
@@ -101,6 +102,9 @@ private:
 
 	[[nodiscard]] bool thumbnailEnoughForSticker() const;
 
+	[[nodiscard]] int64 imagesMemoryBytes() const;
+	void unloadImages(MemoryPriority priority);
+
 	// NB! Right now DocumentMedia can outlive Main::Session!
 	// In DocumentData::collectLocalData a shared_ptr is sent on_main.
 	// In case this is a problem the ~Gif code should be rewritten.
@@ -114,6 +118,8 @@ private:
 	QByteArray _videoThumbnailBytes;
 	Flags _flags;
 
+	mutable MemoryHolder _memory;
+
 };
 
 [[nodiscard]] auto DocumentIconFrameGenerator(not_null<DocumentMedia*> media)
@@ -791,6 +791,7 @@ void ForumTopic::applyTitle(const QString &title) {
 	invalidateTitleWithIcon();
 	_defaultIcon = QImage();
 	indexTitleParts();
+	forum()->topicsList()->indexed()->nameWordsChanged(this);
 	updateChatListEntry();
 	session().changes().topicUpdated(this, UpdateFlag::Title);
 }
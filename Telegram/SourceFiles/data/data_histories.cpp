@@ -23,6 +23,9 @@ https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
 #include "base/unixtime.h"
 #include "base/random.h"
 #include "main/main_session.h"
+#include "storage/cache/storage_cache_types.h"
+#include "storage/storage_history_cache.h"
+#include "storage/storage_shared_media.h"
 #include "window/notifications_manager.h"
 #include "history/history.h"
 #include "history/history_item.h"
@@ -37,6 +40,44 @@ namespace {
 constexpr auto kReadRequestTimeout = 3 * crl::time(1000);
 constexpr auto kReportDeliveriesPerRequest = 50;
 
+// Peers from the cached slice are applied only if we don't know them yet,
+// otherwise they would overwrite the fresh data with the stale one.
+[[nodiscard]] MTPVector<MTPUser> UnknownUsers(
+		not_null<Session*> owner,
+		const MTPVector<MTPUser> &users) {
+	auto result = QVector<MTPUser>();
+	result.reserve(users.v.size());
+	for (const auto &user : users.v) {
+		const auto id = user.match([](const auto &data) {
+			return UserId(data.vid().v);
+		});
+		if (!owner->userLoaded(id)) {
+			result.push_back(user);
+		}
+	}
+	return MTP_vector<MTPUser>(std::move(result));
+}
+
+[[nodiscard]] MTPVector<MTPChat> UnknownChats(
+		not_null<Session*> owner,
+		const MTPVector<MTPChat> &chats) {
+	auto result = QVector<MTPChat>();
+	result.reserve(chats.v.size());
+	for (const auto &chat : chats.v) {
+		const auto id = chat.match([](const MTPDchannel &data) {
+			return peerFromChannel(data.vid().v);
+		}, [](const MTPDchannelForbidden &data) {
+			return peerFromChannel(data.vid().v);
+		}, [](const auto &data) {
+			return peerFromChat(data.vid().v);
+		});
+		if (!owner->peerLoaded(id)) {
+			result.push_back(chat);
+		}
+	}
+	return MTP_vector<MTPChat>(std::move(result));
+}
+
 } // namespace
 
 MTPInputReplyTo ReplyToForMTP(
@@ -127,9 +168,12 @@ MTPInputMedia WebPageForMTP(
 
 Histories::Histories(not_null<Session*> owner)
 : _owner(owner)
+, _cache(std::make_unique<Storage::HistoryCache>(&owner->session()))
 , _readRequestsTimer([=] { sendReadRequests(); }) {
 }
 
+Histories::~Histories() = default;
+
 Session &Histories::owner() const {
 	return *_owner;
 }
@@ -165,6 +209,14 @@ void Histories::clearAll() {
 	_map.clear();
 }
 
+MessagesMemoryUsage Histories::collectMemoryUsage() const {
+	auto result = MessagesMemoryUsage();
+	for (const auto &[peerId, history] : _map) {
+		history->collectMemoryUsage(result);
+	}
+	return result;
+}
+
 void Histories::readInbox(not_null<History*> history) {
 	DEBUG_LOG(("Reading: readInbox called."));
 	if (history->lastServerMessageKnown()) {
@@ -767,6 +819,54 @@ bool Histories::postponeEntryRequest(const State &state) const {
 	});
 }
 
+void Histories::writeCachedSlice(
+		not_null<History*> history,
+		const MTPmessages_Messages &slice) {
+	_cache->put(HistoryCacheKey(history->peer->id), slice);
+}
+
+void Histories::readCachedSlice(
+		not_null<History*> history,
+		Fn<void(const QVector<MTPMessage>&)> done) {
+	readCached(HistoryCacheKey(history->peer->id), std::move(done));
+}
+
+void Histories::writeCachedSharedMedia(
+		not_null<PeerData*> peer,
+		Storage::SharedMediaType type,
+		const MTPmessages_Messages &slice) {
+	_cache->put(SharedMediaCacheKey(peer->id, type), slice);
+}
+
+void Histories::readCachedSharedMedia(
+		not_null<PeerData*> peer,
+		Storage::SharedMediaType type,
+		Fn<void(const QVector<MTPMessage>&)> done) {
+	readCached(SharedMediaCacheKey(peer->id, type), std::move(done));
+}
+
+void Histories::forgetCachedSlice(not_null<History*> history) {
+	const auto peerId = history->peer->id;
+	_cache->remove(HistoryCacheKey(peerId));
+	for (auto i = 0; i != Storage::kSharedMediaTypeCount; ++i) {
+		_cache->remove(
+			SharedMediaCacheKey(peerId, Storage::SharedMediaType(i)));
+	}
+}
+
+void Histories::readCached(
+		const Storage::Cache::Key &key,
+		Fn<void(const QVector<MTPMessage>&)> done) {
+	_cache->get(key, [=](MTPmessages_Messages &&slice) {
+		slice.match([&](const MTPDmessages_messagesNotModified &) {
+		}, [&](const auto &data) {
+			_owner->processUsers(UnknownUsers(_owner, data.vusers()));
+			_owner->processChats(UnknownChats(_owner, data.vchats()));
+			done(data.vmessages().v);
+		});
+	});
+}
+
 void Histories::deleteMessages(
 	not_null<History*> history,
 	const QVector<MTPint> &ids,
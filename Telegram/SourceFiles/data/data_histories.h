@@ -21,6 +21,14 @@ class Error;
 struct Response;
 } // namespace MTP
 
+namespace Storage {
+class HistoryCache;
+enum class SharedMediaType : signed char;
+namespace Cache {
+struct Key;
+} // namespace Cache
+} // namespace Storage
+
 namespace Data {
 
 class Session;
@@ -35,6 +43,20 @@ class SavedSublist;
 	const Data::WebPageDraft &draft,
 	bool required = false);
 
+// Approximate, only the fixed size parts of the items are counted.
+struct MessagesMemoryUsage {
+	struct Component {
+		int count = 0;
+		int64 bytes = 0;
+	};
+	int histories = 0;
+	int items = 0;
+	int views = 0;
+	int64 itemBytes = 0;
+	int64 textBytes = 0;
+	base::flat_map<QString, Component> components;
+};
+
 class Histories final {
 public:
 	enum class RequestType : uchar {
@@ -46,6 +68,7 @@ public:
 	};
 
 	explicit Histories(not_null<Session*> owner);
+	~Histories();
 
 	[[nodiscard]] Session &owner() const;
 	[[nodiscard]] Main::Session &session() const;
@@ -58,6 +81,8 @@ public:
 	void unloadAll();
 	void clearAll();
 
+	[[nodiscard]] MessagesMemoryUsage collectMemoryUsage() const;
+
 	void readInbox(not_null<History*> history);
 	void readInboxTill(not_null<HistoryItem*> item);
 	void readInboxTill(not_null<History*> history, MsgId tillId);
@@ -79,6 +104,22 @@ public:
 
 	void requestGroupAround(not_null<HistoryItem*> item);
 
+	void writeCachedSlice(
+		not_null<History*> history,
+		const MTPmessages_Messages &slice);
+	void readCachedSlice(
+		not_null<History*> history,
+		Fn<void(const QVector<MTPMessage>&)> done);
+	void writeCachedSharedMedia(
+		not_null<PeerData*> peer,
+		Storage::SharedMediaType type,
+		const MTPmessages_Messages &slice);
+	void readCachedSharedMedia(
+		not_null<PeerData*> peer,
+		Storage::SharedMediaType type,
+		Fn<void(const QVector<MTPMessage>&)> done);
+	void forgetCachedSlice(not_null<History*> history);
+
 	void deleteMessages(
 		not_null<History*> history,
 		const QVector<MTPint> &ids,
@@ -214,7 +255,12 @@ private:
 	void sendCreateTopicRequest(not_null<History*> history, MsgId rootId);
 	void cancelDelayedByTopicRequest(int id);
 
+	void readCached(
+		const Storage::Cache::Key &key,
+		Fn<void(const QVector<MTPMessage>&)> done);
+
 	const not_null<Session*> _owner;
+	const std::unique_ptr<Storage::HistoryCache> _cache;
 
 	std::unordered_map<PeerId, std::unique_ptr<History>> _map;
 	base::flat_map<not_null<History*>, State> _states;
@@ -0,0 +1,205 @@
+/*
+This file is part of Telegram Desktop,
+the official desktop application for the Telegram messaging service.
+
+For license and copyright information please follow this link:
+https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
+*/
+#include "data/data_memory_governor.h"
+
+#include "core/application.h"
+#include "ffmpeg/ffmpeg_utility.h"
+
+namespace Data {
+namespace {
+
+constexpr auto kDefaultBudget = int64(512 * 1024 * 1024);
+constexpr auto kCheckDelay = crl::time(1000);
+constexpr auto kVisibleTimeout = crl::time(1000);
+constexpr auto kRecentlyClosedTimeout = 60 * crl::time(1000);
+
+// Evict a bit more than required, so that we don't evict on each check.
+constexpr auto kEvictTargetPercent = 75;
+
+} // namespace
+
+MemoryHolder::MemoryHolder(MemoryHolderDescriptor &&descriptor)
+: _governor(&Core::App().memoryGovernor())
+, _descriptor(std::move(descriptor))
+, _lastUsed(crl::now()) {
+	Expects(_descriptor.bytes != nullptr);
+
+	_governor->registerHolder(this);
+}
+
+MemoryHolder::~MemoryHolder() {
+	_governor->unregisterHolder(this);
+}
+
+void MemoryHolder::touch() {
+	_lastUsed = crl::now();
+	if (!_changed) {
+		_changed = true;
+		_governor->holderChanged(this);
+	}
+}
+
+MemoryPriority MemoryHolder::priority(crl::time now) const {
+	const auto unused = now - _lastUsed;
+	return (unused < kVisibleTimeout)
+		? MemoryPriority::Visible
+		: (unused >= kRecentlyClosedTimeout)
+		? MemoryPriority::RecentlyClosed
+		: MemoryPriority::Offscreen;
+}
+
+void MemoryHolder::unload(MemoryPriority priority) {
+	if (const auto onstack = _descriptor.unload) {
+		onstack(priority);
+	}
+}
+
+int64 MemoryHolder::recount() {
+	const auto was = _accountedBytes;
+	_accountedBytes = _descriptor.bytes();
+	_changed = false;
+	return _accountedBytes - was;
+}
+
+MemoryGovernor::MemoryGovernor()
+: _budget(kDefaultBudget)
+, _checkTimer([=] { check(); }) {
+}
+
+MemoryGovernor::~MemoryGovernor() = default;
+
+void MemoryGovernor::setBudget(int64 bytes) {
+	Expects(bytes > 0);
+
+	if (_budget == bytes) {
+		return;
+	}
+	_budget = bytes;
+
+	// Don't unload right away, the caller may be using some holders.
+	if (_total > _budget) {
+		_checkTimer.callOnce(0);
+	}
+}
+
+int64 MemoryGovernor::budget() const {
+	return _budget;
+}
+
+MemoryUsageSnapshot MemoryGovernor::usage() const {
+	auto result = MemoryUsageSnapshot();
+	for (auto i = 0; i != kMemoryCategoryCount; ++i) {
+		result.categories[i] = { .bytes = _bytes[i], .holders = _counts[i] };
+	}
+	result.total = _total;
+	result.budget = _budget;
+	return result;
+}
+
+rpl::producer<MemoryUsageSnapshot> MemoryGovernor::usageValue() const {
+	return rpl::single(usage()) | rpl::then(_usageUpdates.events());
+}
+
+void MemoryGovernor::registerHolder(not_null<MemoryHolder*> holder) {
+	_holders.emplace(holder);
+	++_counts[int(holder->category())];
+	holderChanged(holder);
+}
+
+void MemoryGovernor::unregisterHolder(not_null<MemoryHolder*> holder) {
+	_holders.remove(holder);
+	_changed.remove(holder);
+	--_counts[int(holder->category())];
+	const auto bytes = holder->accountedBytes();
+	_bytes[int(holder->category())] -= bytes;
+	_total -= bytes;
+}
+
+void MemoryGovernor::holderChanged(not_null<MemoryHolder*> holder) {
+	_changed.emplace(holder);
+	if (!_checkTimer.isActive()) {
+		_checkTimer.callOnce(kCheckDelay);
+	}
+}
+
+void MemoryGovernor::recount(not_null<MemoryHolder*> holder) {
+	const auto delta = holder->recount();
+	_bytes[int(holder->category())] += delta;
+	_total += delta;
+}
+
+void MemoryGovernor::check() {
+	for (const auto &holder : base::take(_changed)) {
+		recount(holder);
+	}
+	if (_total > _budget) {
+		evict();
+
+		// Idle video frame storages are not accounted, free them as well.
+		FFmpeg::TrimFramePool();
+	}
+	_usageUpdates.fire(usage());
+}
+
+void MemoryGovernor::evict() {
+	struct Candidate {
+		not_null<MemoryHolder*> holder;
+		MemoryPriority priority = MemoryPriority::Visible;
+		crl::time lastUsed = 0;
+	};
+	const auto now = crl::now();
+	auto candidates = std::vector<Candidate>();
+	candidates.reserve(_holders.size());
+	for (const auto &holder : _holders) {
+		if (!holder->evictable() || !holder->accountedBytes()) {
+			continue;
+		}
+		const auto priority = holder->priority(now);
+		if (priority != MemoryPriority::Visible) {
+			candidates.push_back({ holder, priority, holder->lastUsed() });
+		}
+	}
+	ranges::sort(candidates, [](const Candidate &a, const Candidate &b) {
+		return (a.priority > b.priority)
+			|| (a.priority == b.priority && a.lastUsed < b.lastUsed);
+	});
+
+	const auto was = _total;
+	const auto target = _budget * kEvictTargetPercent / 100;
+	auto unloaded = 0;
+	for (const auto &candidate : candidates) {
+		if (_total <= target) {
+			break;
+		}
+		const auto holder = candidate.holder;
+
+		// The holder may be destroyed by unloading, then it is
+		// already subtracted from the usage in unregisterHolder().
+		if (!_holders.contains(holder)) {
+			continue;
+		}
+		holder->unload(candidate.priority);
+		if (_holders.contains(holder)) {
+			recount(holder);
+			_changed.remove(holder);
+		}
+		++unloaded;
+	}
+
+	DEBUG_LOG(("Memory Governor: "
+		"Usage %1 -> %2 (images %3, stickers %4, animations %5), "
+		"unloaded %6."
+		).arg(was
+		).arg(_total
+		).arg(_bytes[int(MemoryCategory::Images)]
+		).arg(_bytes[int(MemoryCategory::Stickers)]
+		).arg(_bytes[int(MemoryCategory::Animations)]
+		).arg(unloaded));
+}
+
+} // namespace Data
@@ -0,0 +1,130 @@
+/*
+This file is part of Telegram Desktop,
+the official desktop application for the Telegram messaging service.
+
+For license and copyright information please follow this link:
+https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
+*/
+#pragma once
+
+#include "base/timer.h"
+
+namespace Data {
+
+class MemoryGovernor;
+
+enum class MemoryCategory : uchar {
+	Images,
+	Stickers,
+	Animations,
+};
+inline constexpr auto kMemoryCategoryCount = 3;
+
+struct MemoryUsage {
+	int64 bytes = 0;
+	int holders = 0;
+};
+
+struct MemoryUsageSnapshot {
+	std::array<MemoryUsage, kMemoryCategoryCount> categories;
+	int64 total = 0;
+	int64 budget = 0;
+
+	[[nodiscard]] const MemoryUsage &operator[](
+			MemoryCategory category) const {
+		return categories[static_cast<int>(category)];
+	}
+};
+
+// Holders are evicted from the end of this list to its beginning.
+enum class MemoryPriority : uchar {
+	Visible,
+	Offscreen,
+	RecentlyClosed,
+};
+
+struct MemoryHolderDescriptor {
+	MemoryCategory category = MemoryCategory::Images;
+
+	// Current amount of decoded data, called on the main thread only.
+	Fn<int64()> bytes;
+
+	// Frees everything that can be restored lazily on the next access.
+	// The priority tells how long the holder is left unused, so that
+	// the holder can decide whether to drop the expensive data as well.
+	// May destroy the holder itself, may be null for accounting only.
+	Fn<void(MemoryPriority)> unload;
+};
+
+// Owned by the decoded data holder, registers it in the governor.
+// The usage is recounted only for the holders touched since last check.
+class MemoryHolder final {
+public:
+	explicit MemoryHolder(MemoryHolderDescriptor &&descriptor);
+	MemoryHolder(const MemoryHolder &other) = delete;
+	MemoryHolder &operator=(const MemoryHolder &other) = delete;
+	~MemoryHolder();
+
+	void touch();
+
+	[[nodiscard]] MemoryCategory category() const {
+		return _descriptor.category;
+	}
+	[[nodiscard]] MemoryPriority priority(crl::time now) const;
+	[[nodiscard]] crl::time lastUsed() const {
+		return _lastUsed;
+	}
+	[[nodiscard]] bool evictable() const {
+		return _descriptor.unload != nullptr;
+	}
+	void unload(MemoryPriority priority);
+
+	// For MemoryGovernor.
+	[[nodiscard]] int64 accountedBytes() const {
+		return _accountedBytes;
+	}
+	[[nodiscard]] int64 recount();
+
+private:
+	const not_null<MemoryGovernor*> _governor;
+	const MemoryHolderDescriptor _descriptor;
+	crl::time _lastUsed = 0;
+	bool _changed = false;
+	int64 _accountedBytes = 0;
+
+};
+
+class MemoryGovernor final {
+public:
+	MemoryGovernor();
+	~MemoryGovernor();
+
+	void setBudget(int64 bytes);
+	[[nodiscard]] int64 budget() const;
+
+	// The usage is updated on each check, not on each holder change.
+	[[nodiscard]] MemoryUsageSnapshot usage() const;
+	[[nodiscard]] rpl::producer<MemoryUsageSnapshot> usageValue() const;
+
+	// For MemoryHolder.
+	void registerHolder(not_null<MemoryHolder*> holder);
+	void unregisterHolder(not_null<MemoryHolder*> holder);
+	void holderChanged(not_null<MemoryHolder*> holder);
+
+private:
+	void check();
+	void recount(not_null<MemoryHolder*> holder);
+	void evict();
+
+	base::flat_set<not_null<MemoryHolder*>> _holders;
+	base::flat_set<not_null<MemoryHolder*>> _changed;
+	std::array<int64, kMemoryCategoryCount> _bytes = { { 0 } };
+	std::array<int, kMemoryCategoryCount> _counts = { { 0 } };
+	int64 _total = 0;
+	int64 _budget = 0;
+	base::Timer _checkTimer;
+	rpl::event_stream<MemoryUsageSnapshot> _usageUpdates;
+
+};
+
+} // namespace Data
@@ -14,14 +14,34 @@ https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
 #include "main/main_session.h"
 #include "main/main_session_settings.h"
 #include "storage/file_download.h"
+#include "ui/image/image_prepare.h"
 
 #include <QtGui/QGuiApplication>
 #include <QtGui/QClipboard>
 
 namespace Data {
+namespace {
+
+[[nodiscard]] QImage LimitPhotoImage(QImage image) {
+	const auto limit = PhotoData::SideLimit();
+	return (image.width() > limit || image.height() > limit)
+		? image.scaled(
+			limit,
+			limit,
+			Qt::KeepAspectRatio,
+			Qt::SmoothTransformation)
+		: image;
+}
+
+} // namespace
 
 PhotoMedia::PhotoMedia(not_null<PhotoData*> owner)
-: _owner(owner) {
+: _owner(owner)
+, _memory({
+	.category = MemoryCategory::Images,
+	.bytes = [=] { return imagesMemoryBytes(); },
+	.unload = [=](MemoryPriority priority) { unloadImages(priority); },
+}) {
 }
 
 // NB! Right now DocumentMedia can outlive Main::Session!
@@ -34,6 +54,7 @@ not_null<PhotoData*> PhotoMedia::owner() const {
 }
 
 Image *PhotoMedia::thumbnailInline() const {
+	_memory.touch();
 	if (!_inlineThumbnail) {
 		const auto bytes = _owner->inlineThumbnailBytes();
 		if (!bytes.isEmpty()) {
@@ -49,8 +70,9 @@ Image *PhotoMedia::thumbnailInline() const {
 }
 
 Image *PhotoMedia::image(PhotoSize size) const {
+	_memory.touch();
 	if (const auto resolved = resolveLoadedImage(size)) {
-		return resolved->data.get();
+		return decoded(*resolved);
 	}
 	return nullptr;
 }
@@ -65,13 +87,13 @@ QByteArray PhotoMedia::imageBytes(PhotoSize size) const {
 auto PhotoMedia::resolveLoadedImage(PhotoSize size) const
 -> const PhotoImage * {
 	const auto &original = _images[PhotoSizeIndex(size)];
-	if (original.data) {
+	if (original.present()) {
 		if (original.goodFor >= size) {
 			return &original;
 		}
 	}
 	const auto &valid = _images[_owner->validSizeIndex(size)];
-	if (valid.data.get()) {
+	if (valid.present()) {
 		if (valid.goodFor >= size) {
 			return &valid;
 		}
@@ -79,9 +101,52 @@ auto PhotoMedia::resolveLoadedImage(PhotoSize size) const
 	return nullptr;
 }
 
+Image *PhotoMedia::decoded(const PhotoImage &image) const {
+	if (!image.data && !image.bytes.isEmpty()) {
+		auto read = Images::Read({ .content = image.bytes });
+		if (read.image.isNull()) {
+			return nullptr;
+		}
+		image.data = std::make_unique<Image>(
+			LimitPhotoImage(std::move(read.image)));
+	}
+	return image.data.get();
+}
+
+int64 PhotoMedia::imagesMemoryBytes() const {
+	auto result = _inlineThumbnail
+		? _inlineThumbnail->memoryBytes()
+		: int64(0);
+	for (const auto &image : _images) {
+		if (image.data) {
+			result += image.data->memoryBytes();
+		}
+	}
+	return result;
+}
+
+void PhotoMedia::unloadImages(MemoryPriority priority) {
+	// Images with the original bytes are decoded again on the next access.
+	// Web files are converted to opaque when loaded, so they stay.
+	_inlineThumbnail = nullptr;
+	for (auto i = 0; i != kPhotoSizeCount; ++i) {
+		const auto &image = _images[i];
+		if (!image.data) {
+			continue;
+		} else if (priority == MemoryPriority::RecentlyClosed
+			&& !image.bytes.isEmpty()
+			&& !v::is<WebFileLocation>(
+				_owner->location(PhotoSize(i)).file().data)) {
+			image.data = nullptr;
+		} else {
+			image.data->forgetCache();
+		}
+	}
+}
+
 void PhotoMedia::wanted(PhotoSize size, Data::FileOrigin origin) {
 	const auto index = _owner->validSizeIndex(size);
-	if (!_images[index].data || _images[index].goodFor < size) {
+	if (!_images[index].present() || _images[index].goodFor < size) {
 		_owner->load(size, origin);
 	}
 }
@@ -101,19 +166,12 @@ void PhotoMedia::set(
 		QImage image,
 		QByteArray bytes) {
 	const auto index = PhotoSizeIndex(size);
-	const auto limit = PhotoData::SideLimit();
-	if (image.width() > limit || image.height() > limit) {
-		image = image.scaled(
-			limit,
-			limit,
-			Qt::KeepAspectRatio,
-			Qt::SmoothTransformation);
-	}
 	_images[index] = PhotoImage{
-		.data = std::make_unique<Image>(std::move(image)),
+		.data = std::make_unique<Image>(LimitPhotoImage(std::move(image))),
 		.bytes = std::move(bytes),
 		.goodFor = goodFor,
 	};
+	_memory.touch();
 	_owner->session().notifyDownloaderTaskFinished();
 }
 
@@ -140,7 +198,7 @@ void PhotoMedia::setVideo(PhotoSize size, QByteArray content) {
 
 bool PhotoMedia::loaded() const {
 	const auto index = PhotoSizeIndex(PhotoSize::Large);
-	return (_images[index].data != nullptr)
+	return _images[index].present()
 		&& (_images[index].goodFor >= PhotoSize::Large);
 }
 
@@ -191,7 +249,7 @@ void PhotoMedia::collectLocalData(not_null<PhotoMedia*> local) {
 		_inlineThumbnail = std::make_unique<Image>(image->original());
 	}
 	for (auto i = 0; i != kPhotoSizeCount; ++i) {
-		if (const auto image = local->_images[i].data.get()) {
+		if (const auto image = local->decoded(local->_images[i])) {
 			_images[i] = PhotoImage{
 				.data = std::make_unique<Image>(image->original()),
 				.goodFor = local->_images[i].goodFor
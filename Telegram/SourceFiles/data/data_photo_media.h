@@ -8,6 +8,7 @@ https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
 #pragma once
 
 #include "data/data_photo.h"
+#include "data/data_memory_governor.h"
 
 class FileLoader;
 
@@ -52,12 +53,21 @@ public:
 
 private:
 	struct PhotoImage {
-		std::unique_ptr<Image> data;
+		// May be unloaded by the memory governor if bytes are not empty.
+		mutable std::unique_ptr<Image> data;
 		QByteArray bytes;
 		PhotoSize goodFor = PhotoSize();
+
+		[[nodiscard]] bool present() const {
+			return data || !bytes.isEmpty();
+		}
 	};
 
 	const PhotoImage *resolveLoadedImage(PhotoSize size) const;
+	Image *decoded(const PhotoImage &image) const;
+
+	[[nodiscard]] int64 imagesMemoryBytes() const;
+	void unloadImages(MemoryPriority priority);
 
 	// NB! Right now DocumentMedia can outlive Main::Session!
 	// In DocumentData::collectLocalData a shared_ptr is sent on_main.
@@ -68,6 +78,8 @@ private:
 	QByteArray _videoBytesSmall;
 	QByteArray _videoBytesLarge;
 
+	mutable MemoryHolder _memory;
+
 };
 
 } // namespace Data
@@ -53,6 +53,14 @@ SavedMessages::SavedMessages(
 	if (_owningHistory && _owningHistory->inChatList()) {
 		preloadSublists();
 	}
+
+	// The chats list re-indexes only the history rows on a peer rename.
+	session().changes().realtimeNameUpdates(
+	) | rpl::on_next([=](const NameUpdate &update) {
+		if (const auto sublist = sublistLoaded(update.peer)) {
+			_chatsList.indexed()->nameWordsChanged(sublist);
+		}
+	}, _lifetime);
 }
 
 void SavedMessages::clear() {
@@ -34,6 +34,7 @@ https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
 #include "inline_bots/inline_bot_layout_item.h"
 #include "storage/storage_account.h"
 #include "storage/storage_encrypted_file.h"
+#include "storage/storage_facade.h"
 #include "media/player/media_player_instance.h" // instance()->play()
 #include "media/audio/media_audio.h"
 #include "boxes/abstract_box.h"
@@ -88,6 +89,7 @@ namespace Data {
 namespace {
 
 constexpr auto kNextForUpgradeGiftTimeout = 5 * crl::time(1000);
+constexpr auto kSlowProcessMessagesTime = crl::time(50);
 
 using ViewElement = HistoryView::Element;
 
@@ -2671,7 +2673,10 @@ void Session::updateEditedMessage(const MTPMessage &data) {
 void Session::processMessages(
 		const QVector<MTPMessage> &data,
 		NewMessageType type) {
-	auto indices = base::flat_map<uint64, int>();
+	const auto started = crl::now();
+	auto indices = std::vector<std::pair<uint64, int>>();
+	auto counts = base::flat_map<PeerId, int>();
+	indices.reserve(data.size());
 	for (int i = 0, l = data.size(); i != l; ++i) {
 		const auto &message = data[i];
 		if (message.type() == mtpc_message) {
@@ -2683,14 +2688,39 @@ void Session::processMessages(
 			}
 		}
 		const auto id = IdFromMessage(message); // Only 32 bit values here.
-		indices.emplace((uint64(uint32(id.bare)) << 32) | uint64(i), i);
+		indices.emplace_back((uint64(uint32(id.bare)) << 32) | uint64(i), i);
+		if (message.type() != mtpc_messageEmpty) {
+			if (const auto peerId = PeerFromMessage(message)) {
+				++counts[peerId];
+			}
+		}
+	}
+	if (indices.empty()) {
+		return;
 	}
+	ranges::sort(indices);
+	for (const auto &[peerId, count] : counts) {
+		reserveMessages(peerId, count);
+	}
+
+	// Shared media viewers are notified once for the whole batch.
+	auto &storage = _session->storage();
+	storage.startSharedMediaBatch();
 	for (const auto &[position, index] : indices) {
 		addNewMessage(
 			data[index],
 			MessageFlags(),
 			type);
 	}
+	storage.finishSharedMediaBatch();
+
+	const auto time = crl::now() - started;
+	if (time >= kSlowProcessMessagesTime) {
+		DEBUG_LOG(("Data Info: Processed %1 messages of %2 chats in %3ms."
+			).arg(indices.size()
+			).arg(counts.size()
+			).arg(time));
+	}
 }
 
 void Session::processMessages(
@@ -2750,6 +2780,20 @@ void Session::registerMessage(not_null<HistoryItem*> item) {
 	}
 }
 
+void Session::reserveMessages(PeerId peerId, int count) {
+	// Keep the geometric growth, reserve() allocates the exact amount.
+	const auto reserve = [&](auto &map) {
+		const auto required = map.size() + count;
+		if (required > map.bucket_count() * map.max_load_factor()) {
+			map.reserve(std::max(required, map.size() * 2));
+		}
+	};
+	reserve(*messagesListForInsert(peerId));
+	if (!peerIsChannel(peerId)) {
+		reserve(_nonChannelMessages);
+	}
+}
+
 void Session::registerMessageTTL(TimeId when, not_null<HistoryItem*> item) {
 	Expects(when > 0);
 
@@ -3566,6 +3610,7 @@ void Session::documentConvert(
 	if (idChanged) {
 		cache().moveIfEmpty(oldCacheKey, original->cacheKey());
 		cache().moveIfEmpty(oldGoodKey, original->goodThumbnailCacheKey());
+		stickers().readLocalSavedGifs();
 		if (stickers().savedGifs().indexOf(original) >= 0) {
 			_session->local().writeSavedGifs();
 		}
@@ -20,6 +20,7 @@ class WebFileLocation;
 struct GeoPointLocation;
 
 namespace Storage {
+enum class SharedMediaType : signed char;
 namespace Cache {
 struct Key;
 } // namespace Cache
@@ -54,6 +55,10 @@ Storage::Cache::Key UrlCacheKey(const QString &location);
 Storage::Cache::Key GeoPointCacheKey(const GeoPointLocation &location);
 Storage::Cache::Key AudioAlbumThumbCacheKey(
 	const AudioAlbumThumbLocation &location);
+Storage::Cache::Key HistoryCacheKey(PeerId peerId);
+Storage::Cache::Key SharedMediaCacheKey(
+	PeerId peerId,
+	Storage::SharedMediaType type);
 
 constexpr auto kImageCacheTag = uint8(0x01);
 constexpr auto kStickerCacheTag = uint8(0x02);
@@ -146,6 +146,16 @@ Main::Session &Stickers::session() const {
 	return _owner->session();
 }
 
+void Stickers::readLocalMasks() {
+	auto &local = session().local();
+	local.readInstalledMasks();
+	local.readRecentMasks();
+}
+
+void Stickers::readLocalSavedGifs() {
+	session().local().readSavedGifs();
+}
+
 void Stickers::notifyUpdated(StickersType type) {
 	_updated.fire_copy(type);
 }
@@ -1161,13 +1171,12 @@ std::vector<not_null<DocumentData*>> Stickers::getPremiumList(uint64 seed) {
 		TimeId date = 0;
 	};
 	auto result = std::vector<StickerWithDate>();
+	auto added = std::unordered_set<not_null<DocumentData*>>();
 	auto &sets = setsRef();
 	auto setsToRequest = base::flat_map<uint64, uint64>();
 
 	const auto add = [&](not_null<DocumentData*> document, TimeId date) {
-		if (ranges::find(result, document, [](const StickerWithDate &data) {
-			return data.document;
-		}) == result.end()) {
+		if (added.emplace(document).second) {
 			result.push_back({ document, date });
 		}
 	};
@@ -1220,6 +1229,7 @@ std::vector<not_null<DocumentData*>> Stickers::getPremiumList(uint64 seed) {
 		const auto recent = recentIt->second.get();
 		const auto count = int(recent->stickers.size());
 		result.reserve(count);
+		added.reserve(count);
 		for (auto i = 0; i != count; ++i) {
 			const auto document = recent->stickers[i];
 			auto index = i;
@@ -1234,6 +1244,7 @@ std::vector<not_null<DocumentData*>> Stickers::getPremiumList(uint64 seed) {
 			const auto date = usageDate
 				? usageDate
 				: RecentInstallDate(document);
+			added.emplace(document);
 			result.push_back({
 				document,
 				date ? date : CreateRecentSortKey(document) });
@@ -1302,13 +1313,12 @@ std::vector<not_null<DocumentData*>> Stickers::getListByEmoji(
 		TimeId date = 0;
 	};
 	auto result = std::vector<StickerWithDate>();
+	auto added = std::unordered_set<not_null<DocumentData*>>();
 	auto &sets = setsRef();
 	auto setsToRequest = base::flat_map<uint64, uint64>();
 
 	const auto add = [&](not_null<DocumentData*> document, TimeId date) {
-		if (ranges::find(result, document, [](const StickerWithDate &data) {
-			return data.document;
-		}) == result.end()) {
+		if (added.emplace(document).second) {
 			result.push_back({ document, date });
 		}
 	};
@@ -1373,6 +1383,7 @@ std::vector<not_null<DocumentData*>> Stickers::getListByEmoji(
 		if (list) {
 			const auto count = int(list->size());
 			result.reserve(count);
+			added.reserve(count);
 			for (auto i = 0; i != count; ++i) {
 				const auto document = (*list)[i];
 				const auto sticker = document->sticker();
@@ -1393,6 +1404,7 @@ std::vector<not_null<DocumentData*>> Stickers::getListByEmoji(
 				const auto date = usageDate
 					? usageDate
 					: RecentInstallDate(document);
+				added.emplace(document);
 				result.push_back({
 					document,
 					date ? date : CreateRecentSortKey(document) });
@@ -170,6 +170,7 @@ public:
 		return _maskSetsOrder;
 	}
 	[[nodiscard]] StickersSetsOrder &maskSetsOrderRef() {
+		readLocalMasks();
 		return _maskSetsOrder;
 	}
 	[[nodiscard]] const StickersSetsOrder &emojiSetsOrder() const {
@@ -206,8 +207,15 @@ public:
 		return _savedGifs;
 	}
 	[[nodiscard]] SavedGifs &savedGifsRef() {
+		readLocalSavedGifs();
 		return _savedGifs;
 	}
+
+	// Masks and saved GIFs are needed only in their panels, so they are
+	// read from the disk when a panel is opened or the list is requested.
+	// The const accessors return what was read so far.
+	void readLocalMasks();
+	void readLocalSavedGifs();
 	void removeFromRecentSet(not_null<DocumentData*> document);
 
 	void addSavedGif(
@@ -26,6 +26,7 @@ RowsByLetter IndexedList::addToEnd(Key key) {
 	}
 
 	auto result = RowsByLetter{ _list.addToEnd(key) };
+	indexNameWords(key);
 	for (const auto &ch : key.entry()->chatListFirstLetters()) {
 		auto j = _index.find(ch);
 		if (j == _index.cend()) {
@@ -42,6 +43,7 @@ Row *IndexedList::addByName(Key key) {
 	}
 
 	const auto result = _list.addByName(key);
+	indexNameWords(key);
 	for (const auto &ch : key.entry()->chatListFirstLetters()) {
 		auto j = _index.find(ch);
 		if (j == _index.cend()) {
@@ -127,6 +129,9 @@ void IndexedList::adjustByName(
 	const auto mainRow = _list.adjustByName(key);
 	if (!mainRow) return;
 
+	unindexNameWords(key);
+	indexNameWords(key);
+
 	auto toRemove = oldLetters;
 	auto toAdd = base::flat_set<QChar>();
 	for (const auto &ch : key.entry()->chatListFirstLetters()) {
@@ -164,6 +169,9 @@ void IndexedList::adjustNames(
 	auto mainRow = _list.getRow(key);
 	if (!mainRow) return;
 
+	unindexNameWords(key);
+	indexNameWords(key);
+
 	auto toRemove = oldLetters;
 	auto toAdd = base::flat_set<QChar>();
 	for (const auto &ch : key.entry()->chatListFirstLetters()) {
@@ -194,8 +202,16 @@ void IndexedList::adjustNames(
 	}
 }
 
+void IndexedList::nameWordsChanged(Key key) {
+	if (_nameWordsIndexed && _list.contains(key)) {
+		unindexNameWords(key);
+		indexNameWords(key);
+	}
+}
+
 void IndexedList::remove(Key key, Row *replacedBy) {
 	if (_list.remove(key, replacedBy)) {
+		unindexNameWords(key);
 		for (const auto &ch : key.entry()->chatListFirstLetters()) {
 			if (const auto it = _index.find(ch); it != _index.cend()) {
 				it->second.remove(key, replacedBy);
@@ -207,55 +223,110 @@ void IndexedList::remove(Key key, Row *replacedBy) {
 void IndexedList::clear() {
 	_list.clear();
 	_index.clear();
+	_nameWords.clear();
+	_nameWordsByKey.clear();
+	_nameWordsIndexed = false;
+}
+
+void IndexedList::indexNameWords(Key key) const {
+	if (!_nameWordsIndexed) {
+		return;
+	}
+	const auto &words = key.entry()->chatListNameWords();
+	for (const auto &word : words) {
+		_nameWords.emplace(word, key);
+	}
+	_nameWordsByKey.emplace(key, words);
+}
+
+void IndexedList::unindexNameWords(Key key) const {
+	const auto i = _nameWordsByKey.find(key);
+	if (i == end(_nameWordsByKey)) {
+		return;
+	}
+	for (const auto &word : i->second) {
+		_nameWords.erase(std::make_pair(word, key));
+	}
+	_nameWordsByKey.erase(i);
+}
+
+void IndexedList::ensureNameWordsIndexed() const {
+	if (_nameWordsIndexed) {
+		return;
+	}
+	_nameWordsIndexed = true;
+	for (const auto &row : _list) {
+		indexNameWords(row->key());
+	}
+}
+
+int IndexedList::countNameWordsWithPrefix(
+		const QString &prefix,
+		int limit) const {
+	auto result = 0;
+	for (auto i = _nameWords.lower_bound(std::make_pair(prefix, Key()))
+		; i != end(_nameWords) && i->first.startsWith(prefix)
+		; ++i) {
+		if (++result >= limit) {
+			break;
+		}
+	}
+	return result;
 }
 
 std::vector<not_null<Row*>> IndexedList::filtered(
 		const QStringList &words) const {
-	const auto minimal = [&]() -> const Dialogs::List* {
-		if (empty()) {
-			return nullptr;
+	auto result = std::vector<not_null<Row*>>();
+	if (empty()) {
+		return result;
+	}
+	ensureNameWordsIndexed();
+
+	// Take the candidates for the word with the shortest prefix range.
+	auto shortest = (const QString*)nullptr;
+	auto shortestCount = std::numeric_limits<int>::max();
+	for (const auto &word : words) {
+		if (word.isEmpty()) {
+			continue;
 		}
-		auto result = (const Dialogs::List*)nullptr;
-		for (const auto &word : words) {
-			if (word.isEmpty()) {
-				continue;
-			}
-			const auto found = filtered(word[0]);
-			if (!found || found->empty()) {
-				return nullptr;
-			} else if (!result || result->size() > found->size()) {
-				result = found;
-			}
+		const auto count = countNameWordsWithPrefix(word, shortestCount);
+		if (!count) {
+			return result;
+		} else if (count < shortestCount) {
+			shortest = &word;
+			shortestCount = count;
 		}
+	}
+	if (!shortest) {
 		return result;
-	}();
-	auto result = std::vector<not_null<Row*>>();
-	if (!minimal || minimal->empty()) {
-		return result;
 	}
-	result.reserve(minimal->size());
-	for (const auto &row : *minimal) {
-		const auto &nameWords = row->entry()->chatListNameWords();
+	auto candidates = std::vector<Key>();
+	candidates.reserve(shortestCount);
+	for (auto i = _nameWords.lower_bound(std::make_pair(*shortest, Key()))
+		; i != end(_nameWords) && i->first.startsWith(*shortest)
+		; ++i) {
+		candidates.push_back(i->second);
+	}
+	ranges::sort(candidates);
+	candidates.erase(ranges::unique(candidates), end(candidates));
+
+	result.reserve(candidates.size());
+	for (const auto &key : candidates) {
+		const auto &nameWords = key.entry()->chatListNameWords();
 		const auto found = [&](const QString &word) {
-			for (const auto &name : nameWords) {
-				if (name.startsWith(word)) {
-					return true;
-				}
-			}
-			return false;
+			const auto i = nameWords.lower_bound(word);
+			return (i != end(nameWords)) && i->startsWith(word);
 		};
-		const auto allFound = [&] {
-			for (const auto &word : words) {
-				if (!found(word)) {
-					return false;
-				}
-			}
-			return true;
-		}();
+		const auto allFound = ranges::all_of(words, found);
 		if (allFound) {
-			result.push_back(row);
+			if (const auto row = _list.getRow(key)) {
+				result.push_back(row);
+			}
 		}
 	}
+	ranges::sort(result, ranges::less(), [](not_null<Row*> row) {
+		return row->index();
+	});
 	return result;
 }
 
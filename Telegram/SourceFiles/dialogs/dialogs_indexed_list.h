@@ -41,6 +41,9 @@ public:
 		not_null<PeerData*> peer,
 		const base::flat_set<QChar> &oldChars);
 
+	// For the rows not updated by peerNameChanged(), like topics.
+	void nameWordsChanged(Key key);
+
 	void remove(Key key, Row *replacedBy = nullptr);
 	void clear();
 
@@ -93,11 +96,24 @@ private:
 		not_null<History*> history,
 		const base::flat_set<QChar> &oldChars);
 
+	void indexNameWords(Key key) const;
+	void unindexNameWords(Key key) const;
+	void ensureNameWordsIndexed() const;
+	[[nodiscard]] int countNameWordsWithPrefix(
+		const QString &prefix,
+		int limit) const;
+
 	SortMode _sortMode = SortMode();
 	FilterId _filterId = 0;
 	List _list, _empty;
 	base::flat_map<QChar, List> _index;
 
+	// All the name words of all the rows, sorted for prefix lookups.
+	// Built on the first filtered() call, only the searched lists need it.
+	mutable std::set<std::pair<QString, Key>> _nameWords;
+	mutable std::map<Key, base::flat_set<QString>> _nameWordsByKey;
+	mutable bool _nameWordsIndexed = false;
+
 };
 
 } // namespace Dialogs
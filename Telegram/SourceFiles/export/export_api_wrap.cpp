@@ -23,7 +23,7 @@ namespace {
 
 constexpr auto kUserpicsSliceLimit = 100;
 constexpr auto kFileChunkSize = 1024 * 1024;
-constexpr auto kFileRequestsCount = 2;
+constexpr auto kFileRequestsCount = 4;
 //constexpr auto kFileNextRequestDelay = crl::time(20);
 constexpr auto kChatsSliceLimit = 100;
 constexpr auto kMessagesSliceLimit = 100;
@@ -193,9 +193,15 @@ struct ApiWrap::FileProcess {
 	struct Request {
 		int64 offset = 0;
 		QByteArray bytes;
+		mtpRequestId requestId = 0;
 	};
 	std::deque<Request> requests;
-	mtpRequestId requestId = 0;
+	mtpRequestId referenceRequestId = 0;
+
+	[[nodiscard]] Request *findRequest(int64 offset) {
+		const auto i = ranges::find(requests, offset, &Request::offset);
+		return (i != end(requests)) ? &*i : nullptr;
+	}
 };
 
 struct ApiWrap::FileProgress {
@@ -403,7 +409,7 @@ auto ApiWrap::fileRequest(const Data::FileLocation &location, int64 offset) {
 	Expects(location.dcId != 0
 		|| location.data.type() == mtpc_inputTakeoutFileLocation);
 	Expects(_takeoutId.has_value());
-	Expects(_fileProcess->requestId == 0);
+	Expects(_fileProcess->referenceRequestId == 0);
 
 	return std::move(_mtp.request(MTPInvokeWithTakeout<MTPupload_GetFile>(
 		MTP_long(*_takeoutId),
@@ -413,7 +419,9 @@ auto ApiWrap::fileRequest(const Data::FileLocation &location, int64 offset) {
 			MTP_long(offset),
 			MTP_int(kFileChunkSize))
 	)).fail([=](const MTP::Error &result) {
-		_fileProcess->requestId = 0;
+		if (const auto request = _fileProcess->findRequest(offset)) {
+			request->requestId = 0;
+		}
 		if (result.type() == u"TAKEOUT_FILE_EMPTY"_q
 			&& _otherDataProcess != nullptr) {
 			filePartDone(
@@ -428,7 +436,7 @@ auto ApiWrap::fileRequest(const Data::FileLocation &location, int64 offset) {
 			filePartUnavailable();
 		} else if (result.code() == 400
 			&& result.type().startsWith(u"FILE_REFERENCE_"_q)) {
-			filePartRefreshReference(offset);
+			filePartRefreshReference();
 		} else {
 			error(std::move(result));
 		}
@@ -1549,9 +1557,7 @@ void ApiWrap::skipFile(uint64 randomId) {
 	}
 	LOG(("Export Info: File skipped."));
 	Assert(!_fileProcess->requests.empty());
-	Assert(_fileProcess->requestId != 0);
-	_mtp.request(base::take(_fileProcess->requestId)).cancel();
-	base::take(_fileProcess)->done(QString());
+	takeFileProcess()->done(QString());
 }
 
 void ApiWrap::cancelExportFast() {
@@ -2707,7 +2713,11 @@ bool ApiWrap::writePreloadedFile(
 		return true;
 	} else if (!file.content.isEmpty()) {
 		const auto process = prepareFileProcess(file, origin);
-		if (const auto result = process->file.writeBlock(file.content)) {
+		auto result = process->file.writeBlock(file.content);
+		if (result) {
+			result = process->file.flush();
+		}
+		if (result) {
 			file.relativePath = process->relativePath;
 			_fileCache->save(file.location, file.relativePath);
 		} else {
@@ -2743,7 +2753,7 @@ void ApiWrap::loadFile(
 
 	loadFilePart();
 
-	Ensures(_fileProcess->requestId != 0);
+	Ensures(!_fileProcess->requests.empty());
 }
 
 auto ApiWrap::prepareFileProcess(
@@ -2767,37 +2777,46 @@ auto ApiWrap::prepareFileProcess(
 }
 
 void ApiWrap::loadFilePart() {
-	if (!_fileProcess
-		|| _fileProcess->requestId
-		|| _fileProcess->requests.size() >= kFileRequestsCount
-		|| (_fileProcess->size > 0
-			&& _fileProcess->offset >= _fileProcess->size)) {
+	if (!_fileProcess || _fileProcess->referenceRequestId) {
 		return;
 	}
 
-	const auto offset = _fileProcess->offset;
-	_fileProcess->requests.push_back({ offset });
-	_fileProcess->requestId = fileRequest(
+	// Resend the parts interrupted by a file reference refresh.
+	for (const auto &request : _fileProcess->requests) {
+		if (!request.requestId && request.bytes.isEmpty()) {
+			sendFilePart(request.offset);
+		}
+	}
+
+	// Parts of a file with unknown size are loaded one by one,
+	// until an empty part is received.
+	const auto more = [&] {
+		return (_fileProcess->size > 0)
+			? (_fileProcess->offset < _fileProcess->size)
+			: _fileProcess->requests.empty();
+	};
+	while (_fileProcess->requests.size() < kFileRequestsCount && more()) {
+		const auto offset = _fileProcess->offset;
+		_fileProcess->requests.push_back({ offset });
+		_fileProcess->offset += kFileChunkSize;
+		sendFilePart(offset);
+	}
+}
+
+void ApiWrap::sendFilePart(int64 offset) {
+	Expects(_fileProcess != nullptr);
+
+	const auto request = _fileProcess->findRequest(offset);
+	Assert(request != nullptr);
+	request->requestId = fileRequest(
 		_fileProcess->location,
-		_fileProcess->offset
+		offset
 	).done([=](const MTPupload_File &result) {
-		_fileProcess->requestId = 0;
+		if (const auto request = _fileProcess->findRequest(offset)) {
+			request->requestId = 0;
+		}
 		filePartDone(offset, result);
 	}).send();
-	_fileProcess->offset += kFileChunkSize;
-
-	if (_fileProcess->size > 0
-		&& _fileProcess->requests.size() < kFileRequestsCount) {
-		// Only one request at a time supported right now.
-		//const auto runner = _runner;
-		//crl::on_main([=] {
-		//	QTimer::singleShot(kFileNextRequestDelay, [=] {
-		//		runner([=] {
-		//			loadFilePart();
-		//		});
-		//	});
-		//});
-	}
 }
 
 void ApiWrap::filePartDone(int64 offset, const MTPupload_File &result) {
@@ -2820,16 +2839,12 @@ void ApiWrap::filePartDone(int64 offset, const MTPupload_File &result) {
 			return;
 		}
 	} else {
-		using Request = FileProcess::Request;
-		auto &requests = _fileProcess->requests;
-		const auto i = ranges::find(
-			requests,
-			offset,
-			[](const Request &request) { return request.offset; });
-		Assert(i != end(requests));
+		const auto request = _fileProcess->findRequest(offset);
+		Assert(request != nullptr);
 
-		i->bytes = data.vbytes().v;
+		request->bytes = data.vbytes().v;
 
+		auto &requests = _fileProcess->requests;
 		auto &file = _fileProcess->file;
 		while (!requests.empty() && !requests.front().bytes.isEmpty()) {
 			const auto &bytes = requests.front().bytes;
@@ -2854,28 +2869,39 @@ void ApiWrap::filePartDone(int64 offset, const MTPupload_File &result) {
 		}
 	}
 
+	if (const auto result = _fileProcess->file.flush(); !result) {
+		ioError(result);
+		return;
+	}
 	auto process = base::take(_fileProcess);
 	const auto relativePath = process->relativePath;
 	_fileCache->save(process->location, relativePath);
 	process->done(process->relativePath);
 }
 
-void ApiWrap::filePartRefreshReference(int64 offset) {
+void ApiWrap::filePartRefreshReference() {
 	Expects(_fileProcess != nullptr);
-	Expects(_fileProcess->requestId == 0);
+	Expects(_fileProcess->referenceRequestId == 0);
+
+	// Other parts would fail the same way, request them after refresh.
+	for (auto &request : _fileProcess->requests) {
+		if (const auto requestId = base::take(request.requestId)) {
+			_mtp.request(requestId).cancel();
+		}
+	}
 
 	const auto &origin = _fileProcess->origin;
 	if (origin.storyId) {
-		_fileProcess->requestId = mainRequest(MTPstories_GetStoriesByID(
+		_fileProcess->referenceRequestId = mainRequest(MTPstories_GetStoriesByID(
 			MTP_inputPeerSelf(),
 			MTP_vector<MTPint>(1, MTP_int(origin.storyId))
 		)).fail([=](const MTP::Error &error) {
-			_fileProcess->requestId = 0;
+			_fileProcess->referenceRequestId = 0;
 			filePartUnavailable();
 			return true;
 		}).done([=](const MTPstories_Stories &result) {
-			_fileProcess->requestId = 0;
-			filePartExtractReference(offset, result);
+			_fileProcess->referenceRequestId = 0;
+			filePartExtractReference(result);
 		}).send();
 		return;
 	} else if (!origin.messageId) {
@@ -2892,21 +2918,21 @@ void ApiWrap::filePartRefreshReference(int64 offset) {
 				origin.peer.c_inputPeerChannelFromMessage().vpeer(),
 				origin.peer.c_inputPeerChannelFromMessage().vmsg_id(),
 				origin.peer.c_inputPeerChannelFromMessage().vchannel_id());
-		_fileProcess->requestId = mainRequest(MTPchannels_GetMessages(
+		_fileProcess->referenceRequestId = mainRequest(MTPchannels_GetMessages(
 			channel,
 			MTP_vector<MTPInputMessage>(
 				1,
 				MTP_inputMessageID(MTP_int(origin.messageId)))
 		)).fail([=](const MTP::Error &error) {
-			_fileProcess->requestId = 0;
+			_fileProcess->referenceRequestId = 0;
 			filePartUnavailable();
 			return true;
 		}).done([=](const MTPmessages_Messages &result) {
-			_fileProcess->requestId = 0;
-			filePartExtractReference(offset, result);
+			_fileProcess->referenceRequestId = 0;
+			filePartExtractReference(result);
 		}).send();
 	} else {
-		_fileProcess->requestId = splitRequest(
+		_fileProcess->referenceRequestId = splitRequest(
 			origin.split,
 			MTPmessages_GetMessages(
 				MTP_vector<MTPInputMessage>(
@@ -2914,21 +2940,20 @@ void ApiWrap::filePartRefreshReference(int64 offset) {
 					MTP_inputMessageID(MTP_int(origin.messageId)))
 			)
 		).fail([=](const MTP::Error &error) {
-			_fileProcess->requestId = 0;
+			_fileProcess->referenceRequestId = 0;
 			filePartUnavailable();
 			return true;
 		}).done([=](const MTPmessages_Messages &result) {
-			_fileProcess->requestId = 0;
-			filePartExtractReference(offset, result);
+			_fileProcess->referenceRequestId = 0;
+			filePartExtractReference(result);
 		}).send();
 	}
 }
 
 void ApiWrap::filePartExtractReference(
-		int64 offset,
 		const MTPmessages_Messages &result) {
 	Expects(_fileProcess != nullptr);
-	Expects(_fileProcess->requestId == 0);
+	Expects(_fileProcess->referenceRequestId == 0);
 
 	result.match([&](const MTPDmessages_messagesNotModified &data) {
 		error("Unexpected messagesNotModified received.");
@@ -2952,13 +2977,7 @@ void ApiWrap::filePartExtractReference(
 					_fileProcess->location,
 					message.thumb().file.location);
 				if (refresh1 || refresh2) {
-					_fileProcess->requestId = fileRequest(
-						_fileProcess->location,
-						offset
-					).done([=](const MTPupload_File &result) {
-						_fileProcess->requestId = 0;
-						filePartDone(offset, result);
-					}).send();
+					loadFilePart();
 					return;
 				}
 			}
@@ -2968,10 +2987,9 @@ void ApiWrap::filePartExtractReference(
 }
 
 void ApiWrap::filePartExtractReference(
-		int64 offset,
 		const MTPstories_Stories &result) {
 	Expects(_fileProcess != nullptr);
-	Expects(_fileProcess->requestId == 0);
+	Expects(_fileProcess->referenceRequestId == 0);
 
 	const auto stories = Data::ParseStoriesSlice(
 		result.data().vstories(),
@@ -2985,13 +3003,7 @@ void ApiWrap::filePartExtractReference(
 				_fileProcess->location,
 				story.thumb().file.location);
 			if (refresh1 || refresh2) {
-				_fileProcess->requestId = fileRequest(
-					_fileProcess->location,
-					offset
-				).done([=](const MTPupload_File &result) {
-					_fileProcess->requestId = 0;
-					filePartDone(offset, result);
-				}).send();
+				loadFilePart();
 				return;
 			}
 		}
@@ -3005,10 +3017,33 @@ void ApiWrap::filePartUnavailable() {
 
 	LOG(("Export Error: File unavailable."));
 
-	base::take(_fileProcess)->done(QString());
+	takeFileProcess()->done(QString());
+}
+
+auto ApiWrap::takeFileProcess() -> std::unique_ptr<FileProcess> {
+	Expects(_fileProcess != nullptr);
+
+	for (const auto &request : _fileProcess->requests) {
+		if (request.requestId) {
+			_mtp.request(request.requestId).cancel();
+		}
+	}
+	if (const auto requestId = _fileProcess->referenceRequestId) {
+		_mtp.request(requestId).cancel();
+	}
+	return base::take(_fileProcess);
+}
+
+void ApiWrap::cancelFileProcess() {
+	// The export fails, so the other parts in flight shouldn't be written
+	// or followed by new requests, or report a second error.
+	if (_fileProcess) {
+		takeFileProcess();
+	}
 }
 
 void ApiWrap::error(const MTP::Error &error) {
+	cancelFileProcess();
 	_errors.fire_copy(error);
 }
 
@@ -3018,6 +3053,7 @@ void ApiWrap::error(const QString &text) {
 }
 
 void ApiWrap::ioError(const Output::Result &result) {
+	cancelFileProcess();
 	_ioErrors.fire_copy(result);
 }
 
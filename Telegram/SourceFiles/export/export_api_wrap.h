@@ -267,15 +267,14 @@ private:
 		Fn<bool(FileProgress)> progress,
 		FnMut<void(QString)> done);
 	void loadFilePart();
+	void sendFilePart(int64 offset);
 	void filePartDone(int64 offset, const MTPupload_File &result);
 	void filePartUnavailable();
-	void filePartRefreshReference(int64 offset);
-	void filePartExtractReference(
-		int64 offset,
-		const MTPmessages_Messages &result);
-	void filePartExtractReference(
-		int64 offset,
-		const MTPstories_Stories &result);
+	void filePartRefreshReference();
+	void filePartExtractReference(const MTPmessages_Messages &result);
+	void filePartExtractReference(const MTPstories_Stories &result);
+	std::unique_ptr<FileProcess> takeFileProcess();
+	void cancelFileProcess();
 
 	template <typename Request>
 	class RequestBuilder;
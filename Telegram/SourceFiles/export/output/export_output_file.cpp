@@ -18,16 +18,32 @@ https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
 
 namespace Export {
 namespace Output {
+namespace {
+
+constexpr auto kBufferSize = 1024 * 1024;
+
+} // namespace
 
 File::File(const QString &path, Stats *stats) : _path(path), _stats(stats) {
 }
 
+File::~File() {
+	if (!flush()) {
+		LOG(("Export Error: Could not write the end of '%1'.").arg(_path));
+	} else if (_offset > 0) {
+		DEBUG_LOG(("Export Info: Wrote %1 bytes to '%2' in %3 ms."
+			).arg(_offset
+			).arg(_path
+			).arg(_writeDuration));
+	}
+}
+
 int64 File::size() const {
-	return _offset;
+	return _offset + _buffer.size();
 }
 
 bool File::empty() const {
-	return !_offset;
+	return !size();
 }
 
 Result File::writeBlock(const QByteArray &block) {
@@ -38,22 +54,67 @@ Result File::writeBlock(const QByteArray &block) {
 	return result;
 }
 
+Result File::flush() {
+	const auto result = flushAttempt();
+	if (!result) {
+		_file.reset();
+	}
+	return result;
+}
+
 Result File::writeBlockAttempt(const QByteArray &block) {
 	if (_stats && !_inStats) {
 		_inStats = true;
 		_stats->incrementFiles();
 	}
+
+	// Empty blocks still create the file, so they are not buffered.
+	// The buffer is not changed on errors, so the failed block
+	// may be passed once again after the error is resolved.
+	if (!block.isEmpty() && _buffer.size() + block.size() < kBufferSize) {
+		if (_buffer.isEmpty()) {
+			_buffer.reserve(kBufferSize);
+		}
+		_buffer.append(block);
+	} else if (const auto result = flushAttempt(); !result) {
+		return result;
+	} else if (const auto written = writeAttempt(block); !written) {
+		return written;
+	}
+
+	// Count the buffered bytes as well, so that the progress doesn't lag.
+	if (_stats) {
+		_stats->incrementBytes(block.size());
+	}
+	return Result::Success();
+}
+
+Result File::flushAttempt() {
+	if (_buffer.isEmpty()) {
+		return Result::Success();
+	} else if (const auto result = writeAttempt(_buffer); !result) {
+		return result;
+	}
+	_buffer.clear();
+	return Result::Success();
+}
+
+Result File::writeAttempt(const QByteArray &bytes) {
 	if (const auto result = reopen(); !result) {
 		return result;
 	}
-	const auto size = block.size();
+	const auto size = bytes.size();
 	if (!size) {
 		return Result::Success();
 	}
-	if (_file->write(block) == size && _file->flush()) {
+	const auto started = crl::now();
+	const auto written = (_file->write(bytes) == size) && _file->flush();
+	const auto duration = crl::now() - started;
+	_writeDuration += duration;
+	if (written) {
 		_offset += size;
 		if (_stats) {
-			_stats->incrementBytes(size);
+			_stats->addWritten(size, duration);
 		}
 		return Result::Success();
 	}
@@ -133,7 +194,11 @@ Result File::Copy(
 	if (bytes.size() != f.size()) {
 		return Result(Result::Type::FatalError, source);
 	}
-	return File(path, stats).writeBlock(bytes);
+	auto file = File(path, stats);
+	if (const auto result = file.writeBlock(bytes); !result) {
+		return result;
+	}
+	return file.flush();
 }
 
 } // namespace Output
@@ -22,11 +22,17 @@ class Stats;
 class File {
 public:
 	File(const QString &path, Stats *stats);
+	File(const File &other) = delete;
+	File &operator=(const File &other) = delete;
+	~File();
 
 	[[nodiscard]] int64 size() const;
 	[[nodiscard]] bool empty() const;
 
+	// Small blocks are collected in memory and written together,
+	// call flush() to write them and to get the result of that.
 	[[nodiscard]] Result writeBlock(const QByteArray &block);
+	[[nodiscard]] Result flush();
 
 	[[nodiscard]] static QString PrepareRelativePath(
 		const QString &folder,
@@ -40,13 +46,17 @@ public:
 private:
 	[[nodiscard]] Result reopen();
 	[[nodiscard]] Result writeBlockAttempt(const QByteArray &block);
+	[[nodiscard]] Result writeAttempt(const QByteArray &bytes);
+	[[nodiscard]] Result flushAttempt();
 
 	[[nodiscard]] Result error() const;
 	[[nodiscard]] Result fatalError() const;
 
 	QString _path;
 	int64 _offset = 0;
+	crl::time _writeDuration = 0;
 	std::optional<QFile> _file;
+	QByteArray _buffer;
 
 	Stats *_stats = nullptr;
 	bool _inStats = false;
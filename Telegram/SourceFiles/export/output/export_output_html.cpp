@@ -2673,9 +2673,11 @@ Result HtmlWriter::Wrap::close() {
 		while (!_context.empty()) {
 			block.append(_context.popTag());
 		}
-		return _file.writeBlock(block);
+		if (const auto result = _file.writeBlock(block); !result) {
+			return result;
+		}
 	}
-	return Result::Success();
+	return _file.flush();
 }
 
 QString HtmlWriter::Wrap::relativePath(const QString &path) const {
@@ -2951,7 +2953,11 @@ Result HtmlWriter::writeUserpicsEnd() {
 	if (const auto result = writeDelayedPersonal(QString()); !result) {
 		return result;
 	} else if (_userpics) {
-		return base::take(_userpics)->close();
+		// Keep the file until it is closed, it may hold unwritten data.
+		if (const auto closed = _userpics->close(); !closed) {
+			return closed;
+		}
+		_userpics = nullptr;
 	}
 	return Result::Success();
 }
@@ -3052,7 +3058,10 @@ Result HtmlWriter::writeStoriesSlice(const Data::StoriesSlice &data) {
 Result HtmlWriter::writeStoriesEnd() {
 	pushStoriesSection();
 	if (_stories) {
-		return base::take(_stories)->close();
+		if (const auto closed = _stories->close(); !closed) {
+			return closed;
+		}
+		_stories = nullptr;
 	}
 	return Result::Success();
 }
@@ -3139,7 +3148,10 @@ Result HtmlWriter::writeProfileMusicSlice(const Data::ProfileMusicSlice &data) {
 Result HtmlWriter::writeProfileMusicEnd() {
 	pushProfileMusicSection();
 	if (_profileMusic) {
-		return base::take(_profileMusic)->close();
+		if (const auto closed = _profileMusic->close(); !closed) {
+			return closed;
+		}
+		_profileMusic = nullptr;
 	}
 	return Result::Success();
 }
@@ -3553,9 +3565,11 @@ Result HtmlWriter::writeDialogEnd() {
 		return result;
 	}
 
-	if (const auto closed = base::take(_chat)->close(); !closed) {
+	if (const auto closed = _chat->close(); !closed) {
 		return closed;
-	} else if (_settings.onlySinglePeer()) {
+	}
+	_chat = nullptr;
+	if (_settings.onlySinglePeer()) {
 		return Result::Success();
 	}
 
@@ -3667,7 +3681,10 @@ Result HtmlWriter::validateDialogsMode(bool isLeftChannel) {
 
 Result HtmlWriter::writeDialogsEnd() {
 	if (_chats) {
-		return base::take(_chats)->close();
+		if (const auto closed = _chats->close(); !closed) {
+			return closed;
+		}
+		_chats = nullptr;
 	}
 	return Result::Success();
 }
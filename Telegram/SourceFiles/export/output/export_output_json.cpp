@@ -23,49 +23,81 @@ namespace {
 
 using Context = details::JsonContext;
 
-QByteArray SerializeString(const QByteArray &value) {
+// Large slices are written in parts instead of one block for the whole
+// slice. Nested values, like media and text entities, are still built in
+// their own temporary arrays before being appended to the message.
+constexpr auto kMaxBlockSize = 256 * 1024;
+
+// Keeps the geometric growth when appending many values to one block.
+void Reserve(QByteArray &to, int size) {
+	if (to.capacity() < size) {
+		to.reserve(std::max(size, int(to.capacity()) * 2));
+	}
+}
+
+[[nodiscard]] inline bool NeedsEscaping(const char *p, const char *end) {
+	const auto ch = *p;
+	return (ch >= 0 && ch < 32)
+		|| (ch == '"')
+		|| (ch == '\\')
+		|| (ch == char(0xE2)
+			&& (p + 2 < end)
+			&& *(p + 1) == char(0x80)
+			&& (*(p + 2) == char(0xA8) || *(p + 2) == char(0xA9)));
+}
+
+// Appends the escaped value, copying the runs without special characters.
+void AppendString(QByteArray &to, const QByteArray &value) {
 	const auto size = value.size();
 	const auto begin = value.data();
 	const auto end = begin + size;
 
-	auto result = QByteArray();
-	result.reserve(2 + size * 4);
-	result.append('"');
+	Reserve(to, to.size() + size + 2);
+	to.append('"');
+	auto from = begin;
 	for (auto p = begin; p != end; ++p) {
+		if (!NeedsEscaping(p, end)) {
+			continue;
+		} else if (p != from) {
+			to.append(from, p - from);
+		}
 		const auto ch = *p;
 		if (ch == '\n') {
-			result.append("\\n", 2);
+			to.append("\\n", 2);
 		} else if (ch == '\r') {
-			result.append("\\r", 2);
+			to.append("\\r", 2);
 		} else if (ch == '\t') {
-			result.append("\\t", 2);
+			to.append("\\t", 2);
 		} else if (ch == '"') {
-			result.append("\\\"", 2);
+			to.append("\\\"", 2);
 		} else if (ch == '\\') {
-			result.append("\\\\", 2);
+			to.append("\\\\", 2);
 		} else if (ch >= 0 && ch < 32) {
-			result.append("\\x", 2).append('0' + (ch >> 4));
+			to.append("\\x", 2).append('0' + (ch >> 4));
 			const auto left = (ch & 0x0F);
 			if (left >= 10) {
-				result.append('A' + (left - 10));
-			} else {
-				result.append('0' + left);
-			}
-		} else if (ch == char(0xE2)
-			&& (p + 2 < end)
-			&& *(p + 1) == char(0x80)) {
-			if (*(p + 2) == char(0xA8)) { // Line separator.
-				result.append("\\u2028", 6);
-			} else if (*(p + 2) == char(0xA9)) { // Paragraph separator.
-				result.append("\\u2029", 6);
+				to.append('A' + (left - 10));
 			} else {
-				result.append(ch);
+				to.append('0' + left);
 			}
-		} else {
-			result.append(ch);
+		} else if (*(p + 2) == char(0xA8)) { // Line separator.
+			to.append("\\u2028", 6);
+			p += 2;
+		} else { // Paragraph separator.
+			to.append("\\u2029", 6);
+			p += 2;
 		}
+		from = p + 1;
+	}
+	if (end != from) {
+		to.append(from, end - from);
 	}
-	result.append('"');
+	to.append('"');
+}
+
+QByteArray SerializeString(const QByteArray &value) {
+	auto result = QByteArray();
+	AppendString(result, value);
 	return result;
 }
 
@@ -94,18 +126,23 @@ QByteArray Indentation(const Context &context) {
 	return Indentation(context.nesting.size());
 }
 
-QByteArray SerializeObject(
+void AppendObject(
+		QByteArray &to,
 		Context &context,
 		const std::vector<std::pair<QByteArray, QByteArray>> &values) {
-	const auto indent = Indentation(context);
+	const auto indent = int(context.nesting.size());
+	const auto next = indent + 1;
 
-	context.nesting.push_back(Context::kObject);
-	const auto guard = gsl::finally([&] { context.nesting.pop_back(); });
-	const auto next = '\n' + Indentation(context);
+	auto size = to.size() + indent + 3;
+	for (const auto &[key, value] : values) {
+		if (!value.isEmpty()) {
+			size += next + key.size() + value.size() + 6;
+		}
+	}
+	Reserve(to, size);
 
 	auto first = true;
-	auto result = QByteArray();
-	result.append('{');
+	to.append('{');
 	for (const auto &[key, value] : values) {
 		if (value.isEmpty()) {
 			continue;
@@ -113,23 +150,37 @@ QByteArray SerializeObject(
 		if (first) {
 			first = false;
 		} else {
-			result.append(',');
+			to.append(',');
 		}
-		result.append(next).append(SerializeString(key)).append(": ", 2);
-		result.append(value);
+		to.append('\n').append(next, ' ');
+		AppendString(to, key);
+		to.append(": ", 2).append(value);
 	}
-	result.append('\n').append(indent).append("}");
+	to.append('\n').append(indent, ' ').append('}');
+}
+
+QByteArray SerializeObject(
+		Context &context,
+		const std::vector<std::pair<QByteArray, QByteArray>> &values) {
+	auto result = QByteArray();
+	AppendObject(result, context, values);
 	return result;
 }
 
 QByteArray SerializeArray(
 		Context &context,
 		const std::vector<QByteArray> &values) {
-	const auto indent = Indentation(context.nesting.size());
-	const auto next = '\n' + Indentation(context.nesting.size() + 1);
+	const auto indent = int(context.nesting.size());
+	const auto next = indent + 1;
+
+	auto size = indent + 3;
+	for (const auto &value : values) {
+		size += next + value.size() + 2;
+	}
 
 	auto first = true;
 	auto result = QByteArray();
+	result.reserve(size);
 	result.append('[');
 	for (const auto &value : values) {
 		if (first) {
@@ -137,9 +188,9 @@ QByteArray SerializeArray(
 		} else {
 			result.append(',');
 		}
-		result.append(next).append(value);
+		result.append('\n').append(next, ' ').append(value);
 	}
-	result.append('\n').append(indent).append("]");
+	result.append('\n').append(indent, ' ').append(']');
 	return result;
 }
 
@@ -232,7 +283,8 @@ QByteArray FormatFilePath(const Data::File &file) {
 	return file.relativePath.toUtf8();
 }
 
-QByteArray SerializeMessage(
+void AppendMessage(
+		QByteArray &to,
 		Context &context,
 		const Data::Message &message,
 		const std::map<PeerId, Data::Peer> &peers,
@@ -240,10 +292,11 @@ QByteArray SerializeMessage(
 	using namespace Data;
 
 	if (v::is<UnsupportedMedia>(message.media.content)) {
-		return SerializeObject(context, {
+		AppendObject(to, context, {
 			{ "id", Data::NumberToString(message.id) },
 			{ "type", SerializeString("unsupported") }
 		});
+		return;
 	}
 
 	const auto peer = [&](PeerId peerId) -> const Peer& {
@@ -273,10 +326,6 @@ QByteArray SerializeMessage(
 	{ "date_unixtime", SerializeDateRaw(message.date) },
 	};
 	context.nesting.push_back(Context::kObject);
-	const auto serialized = [&] {
-		context.nesting.pop_back();
-		return SerializeObject(context, values);
-	};
 
 	const auto pushBare = [&](
 			const QByteArray &key,
@@ -1104,7 +1153,8 @@ QByteArray SerializeMessage(
 		context.nesting.pop_back();
 	}
 
-	return serialized();
+	context.nesting.pop_back();
+	AppendObject(to, context, values);
 }
 
 } // namespace
@@ -1336,7 +1386,7 @@ Result JsonWriter::writeProfileMusicSlice(const Data::ProfileMusicSlice &data) {
 	auto block = QByteArray();
 	for (const auto &message : data.list) {
 		block.append(prepareArrayItemStart());
-		block.append(SerializeMessage(_context, message, {}, QString()));
+		AppendMessage(block, _context, message, {}, QString());
 	}
 	return _output->writeBlock(block);
 }
@@ -1670,11 +1720,19 @@ Result JsonWriter::writeDialogSlice(const Data::MessagesSlice &data) {
 		if (Data::SkipMessageByDate(message, _settings)) {
 			continue;
 		}
-		block.append(prepareArrayItemStart() + SerializeMessage(
+		block.append(prepareArrayItemStart());
+		AppendMessage(
+			block,
 			_context,
 			message,
 			data.peers,
-			_environment.internalLinksDomain));
+			_environment.internalLinksDomain);
+		if (block.size() >= kMaxBlockSize) {
+			if (const auto result = _output->writeBlock(block); !result) {
+				return result;
+			}
+			block = QByteArray();
+		}
 	}
 	return block.isEmpty() ? Result::Success() : _output->writeBlock(block);
 }
@@ -1718,11 +1776,14 @@ Result JsonWriter::finish() {
 
 	if (_settings.onlySinglePeer()) {
 		Assert(_context.nesting.empty());
-		return Result::Success();
+		return _output->flush();
 	}
 	auto block = popNesting();
 	Assert(_context.nesting.empty());
-	return _output->writeBlock(block);
+	if (const auto result = _output->writeBlock(block); !result) {
+		return result;
+	}
+	return _output->flush();
 }
 
 QString JsonWriter::mainFilePath() {
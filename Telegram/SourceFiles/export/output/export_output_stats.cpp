@@ -12,7 +12,9 @@ namespace Output {
 
 Stats::Stats(const Stats &other)
 : _files(other._files.load())
-, _bytes(other._bytes.load()) {
+, _bytes(other._bytes.load())
+, _writtenBytes(other._writtenBytes.load())
+, _writeDuration(other._writeDuration.load()) {
 }
 
 void Stats::incrementFiles() {
@@ -23,6 +25,11 @@ void Stats::incrementBytes(int count) {
 	_bytes += count;
 }
 
+void Stats::addWritten(int64 bytes, crl::time duration) {
+	_writtenBytes += bytes;
+	_writeDuration += duration;
+}
+
 int Stats::filesCount() const {
 	return _files;
 }
@@ -31,5 +38,13 @@ int64 Stats::bytesCount() const {
 	return _bytes;
 }
 
+int64 Stats::writtenBytes() const {
+	return _writtenBytes;
+}
+
+crl::time Stats::writeDuration() const {
+	return _writeDuration;
+}
+
 } // namespace Output
 } // namespace Export
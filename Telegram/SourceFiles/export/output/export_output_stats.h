@@ -20,12 +20,19 @@ public:
 	void incrementFiles();
 	void incrementBytes(int count);
 
+	// Bytes actually written to disk and the time it took.
+	void addWritten(int64 bytes, crl::time duration);
+
 	int filesCount() const;
 	int64 bytesCount() const;
+	int64 writtenBytes() const;
+	crl::time writeDuration() const;
 
 private:
 	std::atomic<int> _files;
 	std::atomic<int64> _bytes;
+	std::atomic<int64> _writtenBytes;
+	std::atomic<crl::time> _writeDuration;
 
 };
 
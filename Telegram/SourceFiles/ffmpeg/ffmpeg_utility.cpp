@@ -17,6 +17,8 @@ https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
 
 #include <QImage>
 
+#include <mutex>
+
 #ifdef LIB_FFMPEG_USE_QT_PRIVATE_API
 #include <private/qdrawhelper_p.h>
 #endif // LIB_FFMPEG_USE_QT_PRIVATE_API
@@ -56,9 +58,111 @@ struct HwAccelDescriptor {
 	AVPixelFormat format = AV_PIX_FMT_NONE;
 };
 
+constexpr auto kMaxPooledBytes = int64(32 * 1024 * 1024);
+constexpr auto kMaxPooledInSizeClass = 4;
+
+struct FrameBuffer {
+	std::unique_ptr<uchar[]> memory;
+	uchar *aligned = nullptr;
+	int64 capacity = 0;
+};
+
+// Frame storages are lent from a process-wide pool and returned to it
+// when the last QImage referencing the buffer is destroyed. When no
+// storage is lent anymore nothing is playing, so the pool is freed.
+struct FramePool {
+	std::mutex mutex;
+	base::flat_map<int64, std::vector<FrameBuffer*>> free;
+	FramePoolStats stats;
+	int lent = 0;
+};
+
+void DeleteFrameBuffers(
+		base::flat_map<int64, std::vector<FrameBuffer*>> &&buffers) {
+	for (const auto &[capacity, list] : buffers) {
+		for (const auto buffer : list) {
+			delete buffer;
+		}
+	}
+}
+
+[[nodiscard]] FramePool &Pool() {
+	// Never destroyed, frames may be released after the static cleanup.
+	static const auto result = new FramePool();
+	return *result;
+}
+
+// Round up by a step of 1/16 .. 1/8 of the size, so that frames of
+// close resolutions share buffers and the waste stays below 12.5%.
+[[nodiscard]] int64 FrameBufferSizeClass(int64 size) {
+	auto step = int64(kAlignImageBy);
+	while (step * 16 <= size) {
+		step *= 2;
+	}
+	return ((size + step - 1) / step) * step;
+}
+
+[[nodiscard]] FrameBuffer *LendFrameBuffer(int64 size) {
+	const auto capacity = FrameBufferSizeClass(size);
+	auto &pool = Pool();
+	auto lock = std::unique_lock(pool.mutex);
+	auto &stats = pool.stats;
+	++pool.lent;
+	stats.lentBytes += capacity;
+	const auto i = pool.free.find(capacity);
+	if (i != end(pool.free) && !i->second.empty()) {
+		const auto result = i->second.back();
+		i->second.pop_back();
+		stats.pooledBytes -= capacity;
+		++stats.hits;
+		return result;
+	}
+	++stats.misses;
+	stats.peakBytes = std::max(
+		stats.peakBytes,
+		stats.lentBytes + stats.pooledBytes);
+	lock.unlock();
+
+	auto result = new FrameBuffer{
+		.memory = std::unique_ptr<uchar[]>(
+			new uchar[capacity + kAlignImageBy]),
+		.capacity = capacity,
+	};
+	const auto address = reinterpret_cast<uintptr_t>(result->memory.get());
+	result->aligned = result->memory.get() + ((address % kAlignImageBy)
+		? (kAlignImageBy - (address % kAlignImageBy))
+		: 0);
+	return result;
+}
+
+void ReturnFrameBuffer(FrameBuffer *buffer) {
+	auto &pool = Pool();
+	auto lock = std::unique_lock(pool.mutex);
+	const auto capacity = buffer->capacity;
+	pool.stats.lentBytes -= capacity;
+	if (!--pool.lent) {
+		auto free = base::take(pool.free);
+		pool.stats.pooledBytes = 0;
+		lock.unlock();
+
+		DeleteFrameBuffers(std::move(free));
+		delete buffer;
+		return;
+	}
+	auto &list = pool.free[capacity];
+	if (list.size() < kMaxPooledInSizeClass
+		&& pool.stats.pooledBytes + capacity <= kMaxPooledBytes) {
+		list.push_back(buffer);
+		pool.stats.pooledBytes += capacity;
+		return;
+	}
+	lock.unlock();
+
+	delete buffer;
+}
+
 void AlignedImageBufferCleanupHandler(void* data) {
-	const auto buffer = static_cast<uchar*>(data);
-	delete[] buffer;
+	ReturnFrameBuffer(static_cast<FrameBuffer*>(data));
 }
 
 [[nodiscard]] bool IsValidAspectRatio(AVRational aspect) {
@@ -691,14 +795,10 @@ QImage CreateFrameStorage(QSize size) {
 		? (widthAlign - (width % widthAlign))
 		: 0);
 	const auto perLine = neededWidth * kPixelBytesSize;
-	const auto buffer = new uchar[perLine * height + kAlignImageBy];
+	const auto buffer = LendFrameBuffer(int64(perLine) * height);
 	const auto cleanupData = static_cast<void *>(buffer);
-	const auto address = reinterpret_cast<uintptr_t>(buffer);
-	const auto alignedBuffer = buffer + ((address % kAlignImageBy)
-		? (kAlignImageBy - (address % kAlignImageBy))
-		: 0);
 	return QImage(
-		alignedBuffer,
+		buffer->aligned,
 		width,
 		height,
 		perLine,
@@ -707,6 +807,22 @@ QImage CreateFrameStorage(QSize size) {
 		cleanupData);
 }
 
+FramePoolStats CollectFramePoolStats() {
+	auto &pool = Pool();
+	auto lock = std::unique_lock(pool.mutex);
+	return pool.stats;
+}
+
+void TrimFramePool() {
+	auto &pool = Pool();
+	auto lock = std::unique_lock(pool.mutex);
+	auto free = base::take(pool.free);
+	pool.stats.pooledBytes = 0;
+	lock.unlock();
+
+	DeleteFrameBuffers(std::move(free));
+}
+
 void UnPremultiply(QImage &dst, const QImage &src) {
 	// This creates QImage::Format_ARGB32_Premultiplied, but we use it
 	// as an image in QImage::Format_ARGB32 format.
@@ -234,6 +234,19 @@ void LogError(
 [[nodiscard]] bool GoodStorageForFrame(const QImage &storage, QSize size);
 [[nodiscard]] QImage CreateFrameStorage(QSize size);
 
+struct FramePoolStats {
+	int64 hits = 0;
+	int64 misses = 0;
+	int64 lentBytes = 0;
+	int64 pooledBytes = 0;
+	int64 peakBytes = 0;
+};
+
+// Storages from CreateFrameStorage are reused between all the players,
+// the idle ones are freed by TrimFramePool.
+[[nodiscard]] FramePoolStats CollectFramePoolStats();
+void TrimFramePool();
+
 void UnPremultiply(QImage &to, const QImage &from);
 void PremultiplyInplace(QImage &image);
 
@@ -0,0 +1,263 @@
+/*
+This file is part of Telegram Desktop,
+the official desktop application for the Telegram messaging service.
+
+For license and copyright information please follow this link:
+https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
+*/
+#include "ffmpeg/ffmpeg_yuv_convert.h"
+
+#include <QtGui/QImage>
+
+#if defined __SSE2__ || defined _M_X64 || (defined _M_IX86_FP && _M_IX86_FP >= 2)
+#define FFMPEG_YUV_CONVERT_SSE2
+#include <emmintrin.h>
+#endif // __SSE2__ || _M_X64 || _M_IX86_FP >= 2
+
+namespace FFmpeg {
+namespace {
+
+// BT.601 coefficients multiplied by 8192. Samples are shifted left by 8
+// bits and only the high 16 bits of the products are kept, as in
+// _mm_mulhi_epi16, so the results keep 5 fractional bits.
+struct Coefficients {
+	int yOffset = 0; // Luma offset in the same 5 fractional bits.
+	int y = 0;
+	int rv = 0;
+	int gu = 0;
+	int gv = 0;
+	int bu = 0;
+};
+
+constexpr auto kLimitedRange = Coefficients{
+	.yOffset = 596, // (16 << 8) * 9539 >> 16
+	.y = 9539,
+	.rv = 13075,
+	.gu = 3209,
+	.gv = 6660,
+	.bu = 16525,
+};
+
+constexpr auto kFullRange = Coefficients{
+	.yOffset = 0,
+	.y = 8192,
+	.rv = 11485,
+	.gu = 2819,
+	.gv = 5850,
+	.bu = 14516,
+};
+
+constexpr auto kFractionBits = 5;
+constexpr auto kRounding = (1 << (kFractionBits - 1));
+
+[[nodiscard]] inline uchar Clamp(int value) {
+	return uchar(std::clamp(value, 0, 255));
+}
+
+[[nodiscard]] inline int MulHigh(int sample, int coefficient) {
+	return (sample * 256 * coefficient) >> 16;
+}
+
+[[nodiscard]] inline uint32 Pixel(
+		const Coefficients &c,
+		int y,
+		int u,
+		int v) {
+	const auto luma = MulHigh(y, c.y) - c.yOffset + kRounding;
+	u -= 128;
+	v -= 128;
+	const auto r = Clamp((luma + MulHigh(v, c.rv)) >> kFractionBits);
+	const auto g = Clamp(
+		(luma - MulHigh(u, c.gu) - MulHigh(v, c.gv)) >> kFractionBits);
+	const auto b = Clamp((luma + MulHigh(u, c.bu)) >> kFractionBits);
+	return 0xFF000000U | (uint32(r) << 16) | (uint32(g) << 8) | uint32(b);
+}
+
+void ConvertRowScalar(
+		const Coefficients &c,
+		const uchar *y,
+		const uchar *u,
+		const uchar *v,
+		int from,
+		int till,
+		uint32 *to) {
+	for (auto x = from; x != till; ++x) {
+		const auto chroma = (x >> 1);
+		to[x] = v
+			? Pixel(c, y[x], u[chroma], v[chroma])
+			: Pixel(c, y[x], u[2 * chroma], u[2 * chroma + 1]);
+	}
+}
+
+#ifdef FFMPEG_YUV_CONVERT_SSE2
+
+// Converts 8 pixels of 16 bit Y, U and V values to 8 bit B, G and R.
+inline void ConvertEight(
+		const Coefficients &c,
+		__m128i y,
+		__m128i u,
+		__m128i v,
+		__m128i &b,
+		__m128i &g,
+		__m128i &r) {
+	// Luma is unsigned after the shift, chroma is signed.
+	const auto luma = _mm_sub_epi16(
+		_mm_mulhi_epu16(
+			_mm_slli_epi16(y, 8),
+			_mm_set1_epi16(short(c.y))),
+		_mm_set1_epi16(short(c.yOffset - kRounding)));
+	u = _mm_slli_epi16(_mm_sub_epi16(u, _mm_set1_epi16(128)), 8);
+	v = _mm_slli_epi16(_mm_sub_epi16(v, _mm_set1_epi16(128)), 8);
+	r = _mm_srai_epi16(
+		_mm_add_epi16(luma, _mm_mulhi_epi16(v, _mm_set1_epi16(short(c.rv)))),
+		kFractionBits);
+	g = _mm_srai_epi16(
+		_mm_sub_epi16(
+			_mm_sub_epi16(
+				luma,
+				_mm_mulhi_epi16(u, _mm_set1_epi16(short(c.gu)))),
+			_mm_mulhi_epi16(v, _mm_set1_epi16(short(c.gv)))),
+		kFractionBits);
+	b = _mm_srai_epi16(
+		_mm_add_epi16(luma, _mm_mulhi_epi16(u, _mm_set1_epi16(short(c.bu)))),
+		kFractionBits);
+}
+
+inline void StoreSixteen(
+		__m128i b,
+		__m128i g,
+		__m128i r,
+		uint32 *to) {
+	const auto alpha = _mm_set1_epi8(char(0xFF));
+	const auto bgLow = _mm_unpacklo_epi8(b, g);
+	const auto bgHigh = _mm_unpackhi_epi8(b, g);
+	const auto raLow = _mm_unpacklo_epi8(r, alpha);
+	const auto raHigh = _mm_unpackhi_epi8(r, alpha);
+	const auto out = reinterpret_cast<__m128i*>(to);
+	_mm_storeu_si128(out + 0, _mm_unpacklo_epi16(bgLow, raLow));
+	_mm_storeu_si128(out + 1, _mm_unpackhi_epi16(bgLow, raLow));
+	_mm_storeu_si128(out + 2, _mm_unpacklo_epi16(bgHigh, raHigh));
+	_mm_storeu_si128(out + 3, _mm_unpackhi_epi16(bgHigh, raHigh));
+}
+
+// Returns the count of converted pixels, the rest is left for scalar.
+int ConvertRowSSE2(
+		const Coefficients &c,
+		const uchar *y,
+		const uchar *u,
+		const uchar *v,
+		int width,
+		uint32 *to) {
+	const auto zero = _mm_setzero_si128();
+	const auto lowBytes = _mm_set1_epi16(0x00FF);
+	auto x = 0;
+	for (; x + 16 <= width; x += 16) {
+		const auto luma = _mm_loadu_si128(
+			reinterpret_cast<const __m128i*>(y + x));
+		auto uHalf = __m128i();
+		auto vHalf = __m128i();
+		if (v) {
+			uHalf = _mm_unpacklo_epi8(
+				_mm_loadl_epi64(reinterpret_cast<const __m128i*>(u + x / 2)),
+				zero);
+			vHalf = _mm_unpacklo_epi8(
+				_mm_loadl_epi64(reinterpret_cast<const __m128i*>(v + x / 2)),
+				zero);
+		} else {
+			const auto uv = _mm_loadu_si128(
+				reinterpret_cast<const __m128i*>(u + x));
+			uHalf = _mm_and_si128(uv, lowBytes);
+			vHalf = _mm_srli_epi16(uv, 8);
+		}
+		auto bLow = __m128i(), gLow = __m128i(), rLow = __m128i();
+		auto bHigh = __m128i(), gHigh = __m128i(), rHigh = __m128i();
+		ConvertEight(
+			c,
+			_mm_unpacklo_epi8(luma, zero),
+			_mm_unpacklo_epi16(uHalf, uHalf),
+			_mm_unpacklo_epi16(vHalf, vHalf),
+			bLow,
+			gLow,
+			rLow);
+		ConvertEight(
+			c,
+			_mm_unpackhi_epi8(luma, zero),
+			_mm_unpackhi_epi16(uHalf, uHalf),
+			_mm_unpackhi_epi16(vHalf, vHalf),
+			bHigh,
+			gHigh,
+			rHigh);
+		StoreSixteen(
+			_mm_packus_epi16(bLow, bHigh),
+			_mm_packus_epi16(gLow, gHigh),
+			_mm_packus_epi16(rLow, rHigh),
+			to + x);
+	}
+	return x;
+}
+
+#endif // FFMPEG_YUV_CONVERT_SSE2
+
+template <typename RowConverter>
+void Convert(
+		const Yuv420Planes &planes,
+		QSize size,
+		uchar *to,
+		int toStride,
+		RowConverter &&convertRow) {
+	const auto &c = planes.fullRange ? kFullRange : kLimitedRange;
+	const auto width = size.width();
+	for (auto row = 0, height = size.height(); row != height; ++row) {
+		const auto chromaRow = (row >> 1);
+		const auto y = planes.y + row * planes.yStride;
+		const auto u = planes.u + chromaRow * planes.uStride;
+		const auto v = planes.v
+			? (planes.v + chromaRow * planes.vStride)
+			: nullptr;
+		const auto line = reinterpret_cast<uint32*>(to + row * toStride);
+		const auto done = convertRow(c, y, u, v, width, line);
+		ConvertRowScalar(c, y, u, v, done, width, line);
+	}
+}
+
+} // namespace
+
+void Yuv420ToBgra(
+		const Yuv420Planes &planes,
+		QSize size,
+		uchar *to,
+		int toStride) {
+#ifdef FFMPEG_YUV_CONVERT_SSE2
+	Convert(planes, size, to, toStride, ConvertRowSSE2);
+#else // FFMPEG_YUV_CONVERT_SSE2
+	Convert(planes, size, to, toStride, [](auto&&...) { return 0; });
+#endif // FFMPEG_YUV_CONVERT_SSE2
+}
+
+bool Yuv420ToBgraSupported(not_null<const AVFrame*> frame) {
+	switch (frame->format) {
+	case AV_PIX_FMT_YUV420P:
+	case AV_PIX_FMT_YUVJ420P:
+	case AV_PIX_FMT_NV12:
+		return (frame->width > 0) && (frame->height > 0);
+	}
+	return false;
+}
+
+void Yuv420ToBgra(not_null<const AVFrame*> frame, QImage &storage) {
+	Expects(Yuv420ToBgraSupported(frame));
+	Expects(storage.size() == QSize(frame->width, frame->height));
+
+	const auto nv12 = (frame->format == AV_PIX_FMT_NV12);
+	Yuv420ToBgra({
+		.y = frame->data[0],
+		.u = frame->data[1],
+		.v = nv12 ? nullptr : frame->data[2],
+		.yStride = frame->linesize[0],
+		.uStride = frame->linesize[1],
+		.vStride = nv12 ? 0 : frame->linesize[2],
+		.fullRange = (frame->format == AV_PIX_FMT_YUVJ420P),
+	}, storage.size(), storage.bits(), storage.bytesPerLine());
+}
+
+} // namespace FFmpeg
@@ -0,0 +1,36 @@
+/*
+This file is part of Telegram Desktop,
+the official desktop application for the Telegram messaging service.
+
+For license and copyright information please follow this link:
+https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
+*/
+#pragma once
+
+#include "ffmpeg/ffmpeg_utility.h"
+
+namespace FFmpeg {
+
+struct Yuv420Planes {
+	const uchar *y = nullptr;
+	const uchar *u = nullptr; // Interleaved UV if v == nullptr (NV12).
+	const uchar *v = nullptr;
+	int yStride = 0;
+	int uStride = 0;
+	int vStride = 0;
+	bool fullRange = false;
+};
+
+// BT.601, same as swscale without explicit colorspace details.
+void Yuv420ToBgra(
+	const Yuv420Planes &planes,
+	QSize size,
+	uchar *to,
+	int toStride);
+
+[[nodiscard]] bool Yuv420ToBgraSupported(not_null<const AVFrame*> frame);
+
+// Frame size must be equal to the storage size, no scaling is done.
+void Yuv420ToBgra(not_null<const AVFrame*> frame, QImage &storage);
+
+} // namespace FFmpeg
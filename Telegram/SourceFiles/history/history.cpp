@@ -79,8 +79,13 @@ https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
 namespace {
 
 constexpr auto kNewBlockEachMessage = 50;
+constexpr auto kEagerResizeBlocks = 4;
 constexpr auto kSkipCloudDraftsFor = TimeId(2);
 
+// Release the buckets when most of the items were destroyed.
+constexpr auto kShrinkItemsMinBuckets = 256;
+constexpr auto kShrinkItemsLoadFactor = 4;
+
 using UpdateFlag = Data::HistoryUpdate::Flag;
 
 [[nodiscard]] HistoryItemCommonFields WithLocalFlag(
@@ -97,6 +102,19 @@ using UpdateFlag = Data::HistoryUpdate::Flag;
 	return state;
 }
 
+template <typename Component>
+void AccumulateComponent(
+		Data::MessagesMemoryUsage &usage,
+		not_null<const HistoryItem*> item,
+		const QString &name) {
+	if (item->Has<Component>()) {
+		auto &component = usage.components[name];
+		++component.count;
+		component.bytes += sizeof(Component);
+		usage.itemBytes += sizeof(Component);
+	}
+}
+
 } // namespace
 
 History::History(not_null<Data::Session*> owner, PeerId peerId)
@@ -506,7 +524,8 @@ not_null<HistoryItem*> History::createItem(
 		if (detachExistingItem) {
 			result->removeMainView();
 		}
-		if (result->needsUpdateForVideoQualities(message)) {
+		if (_cachedSliceIds.remove(id)
+			|| result->needsUpdateForVideoQualities(message)) {
 			owner().updateEditedMessage(message);
 		}
 		return result;
@@ -527,6 +546,7 @@ std::vector<not_null<HistoryItem*>> History::createItems(
 		const QVector<MTPMessage> &data) {
 	auto result = std::vector<not_null<HistoryItem*>>();
 	result.reserve(data.size());
+	owner().reserveMessages(peer->id, data.size());
 	const auto localFlags = MessageFlags();
 	const auto detachExistingItem = true;
 	for (auto i = data.cend(), e = data.cbegin(); i != e;) {
@@ -615,6 +635,7 @@ void History::destroyMessage(not_null<HistoryItem*> item) {
 
 	owner().unregisterMessage(item);
 	Core::App().notifications().clearFromItem(item);
+	_cachedSliceIds.remove(item->id);
 
 	auto hack = std::unique_ptr<HistoryItem>(item.get());
 	const auto i = _items.find(hack);
@@ -622,6 +643,10 @@ void History::destroyMessage(not_null<HistoryItem*> item) {
 
 	Assert(i != end(_items));
 	_items.erase(i);
+	if (_items.bucket_count() > kShrinkItemsMinBuckets
+		&& _items.size() * kShrinkItemsLoadFactor < _items.bucket_count()) {
+		_items.rehash(0);
+	}
 
 	if (documentToCancel) {
 		session().data().documentMessageRemoved(documentToCancel);
@@ -1647,6 +1672,111 @@ void History::addNewerSlice(const QVector<MTPMessage> &slice) {
 	checkLastMessage();
 }
 
+void History::addCachedSlice(const QVector<MTPMessage> &slice) {
+	if (!isEmpty() || slice.isEmpty()) {
+		return;
+	}
+	auto cachedIds = std::vector<MsgId>();
+	cachedIds.reserve(slice.size());
+	for (const auto &message : slice) {
+		const auto id = IdFromMessage(message);
+		if (!owner().message(peer, id)) {
+			cachedIds.push_back(id);
+		}
+	}
+	const auto added = createItems(slice);
+	if (added.empty()) {
+		return;
+	}
+	for (const auto id : cachedIds) {
+		_cachedSliceIds.emplace(id);
+	}
+	startBuildingFrontBlock(added.size());
+	for (const auto &item : added) {
+		addItemToBlock(item);
+	}
+	finishBuildingFrontBlock();
+	_cachedSliceShown = true;
+}
+
+void History::dropCachedSlice(const QVector<MTPMessage> &fresh) {
+	if (!_cachedSliceShown) {
+		return;
+	}
+	const auto loadedAtBottom = _loadedAtBottom;
+	clear(ClearType::Unload);
+	_loadedAtBottom = loadedAtBottom;
+
+	auto freshIds = base::flat_set<MsgId>();
+	auto minFreshId = std::numeric_limits<MsgId>::max();
+	for (const auto &message : fresh) {
+		const auto id = IdFromMessage(message);
+		freshIds.emplace(id);
+		minFreshId = std::min(minFreshId, id);
+	}
+
+	// Cached messages inside the fresh slice range that the server didn't
+	// return were deleted while we were offline. Older ones stay unloaded
+	// and get refreshed in createItem() when they are received again.
+	auto deleted = std::vector<not_null<HistoryItem*>>();
+	for (const auto id : _cachedSliceIds) {
+		if (fresh.isEmpty() || (id >= minFreshId && !freshIds.contains(id))) {
+			if (const auto item = owner().message(peer, id)) {
+				deleted.push_back(item);
+			}
+		}
+	}
+	for (const auto &item : deleted) {
+		item->destroy();
+	}
+}
+
+bool History::hasCachedSlice() const {
+	return _cachedSliceShown;
+}
+
+bool History::isCachedSliceItem(MsgId id) const {
+	return _cachedSliceIds.contains(id);
+}
+
+void History::collectMemoryUsage(Data::MessagesMemoryUsage &usage) const {
+	++usage.histories;
+	for (const auto &item : _items) {
+		++usage.items;
+		usage.itemBytes += sizeof(HistoryItem);
+		if (item->mainView()) {
+			++usage.views;
+		}
+		const auto &text = item->originalText();
+		usage.textBytes += text.text.size() * sizeof(QChar)
+			+ text.entities.size() * sizeof(EntityInText);
+
+		const auto raw = item.get();
+		AccumulateComponent<HistoryMessageVia>(usage, raw, u"via"_q);
+		AccumulateComponent<HistoryMessageViews>(usage, raw, u"views"_q);
+		AccumulateComponent<HistoryMessageSigned>(usage, raw, u"signed"_q);
+		AccumulateComponent<HistoryMessageEdited>(usage, raw, u"edited"_q);
+		AccumulateComponent<HistoryMessageForwarded>(
+			usage,
+			raw,
+			u"forwarded"_q);
+		AccumulateComponent<HistoryMessageReply>(usage, raw, u"reply"_q);
+		AccumulateComponent<HistoryMessageReplyMarkup>(
+			usage,
+			raw,
+			u"markup"_q);
+		AccumulateComponent<HistoryMessageTranslation>(
+			usage,
+			raw,
+			u"translation"_q);
+		AccumulateComponent<HistoryMessageFactcheck>(
+			usage,
+			raw,
+			u"factcheck"_q);
+		AccumulateComponent<HistoryServiceData>(usage, raw, u"service"_q);
+	}
+}
+
 void History::checkLastMessage() {
 	if (const auto last = lastMessage()) {
 		if (!_loadedAtBottom && last->mainView()) {
@@ -2588,6 +2718,10 @@ bool History::isReadyFor(MsgId msgId) {
 		// Old group history.
 		return owner().history(peer->migrateFrom()->id)->isReadyFor(-msgId);
 	}
+	if (_cachedSliceShown) {
+		// The cached slice is shown only until the first fresh one.
+		return false;
+	}
 
 	if (msgId == ShowAtTheEndMsgId) {
 		return loadedAtBottom();
@@ -3388,14 +3522,54 @@ void History::resizeToWidth(int newWidth) {
 	_flags &= ~(Flag::HasPendingResizedItems | Flag::PendingAllItemsResize);
 
 	_width = newWidth;
-	int y = 0;
-	for (const auto &block : blocks) {
+	const auto [from, till] = (request == Request::ResizePending)
+		? std::make_pair(0, int(blocks.size()))
+		: countEagerResizeBlocks();
+	auto y = 0;
+	for (auto i = 0, count = int(blocks.size()); i != count; ++i) {
+		const auto &block = blocks[i];
 		block->setY(y);
-		y += block->resizeGetHeight(newWidth, request);
+		if (i >= from && i < till) {
+			y += block->resizeGetHeight(newWidth, request);
+		} else {
+			block->deferResize(request);
+			y += block->resizeGetHeight(newWidth, Request::ResizePending);
+		}
 	}
 	_height = y;
 }
 
+std::pair<int, int> History::countEagerResizeBlocks() const {
+	const auto count = int(blocks.size());
+	const auto anchor = scrollTopItem
+		? scrollTopItem->block()->indexInHistory()
+		: (count - 1);
+	return {
+		std::max(anchor - kEagerResizeBlocks, 0),
+		std::min(anchor + kEagerResizeBlocks + 1, count),
+	};
+}
+
+bool History::resizeDeferredBlocks(int top, int bottom) {
+	using Request = HistoryBlock::ResizeRequest;
+	auto found = false;
+	auto y = 0;
+	for (const auto &block : blocks) {
+		const auto resize = block->resizeDeferred()
+			&& (y < bottom)
+			&& (y + block->height() > top);
+		block->setY(y);
+		y += resize
+			? block->resizeGetHeight(_width, Request::ResizeAll)
+			: block->height();
+		found = found || resize;
+	}
+	if (found) {
+		_height = y;
+	}
+	return found;
+}
+
 void History::forceFullResize() {
 	_width = 0;
 	_flags |= Flag::HasPendingResizedItems;
@@ -3940,11 +4114,16 @@ void History::clear(ClearType type, bool markEmpty) {
 
 	forgetScrollState();
 	blocks.clear();
+	blocks.shrink_to_fit();
 	owner().notifyHistoryUnloaded(this);
 	lastKeyboardInited = false;
+	_cachedSliceShown = false;
 	if (type == ClearType::Unload) {
 		_loadedAtTop = _loadedAtBottom = markEmpty;
 	} else {
+		_cachedSliceIds.clear();
+		owner().histories().forgetCachedSlice(this);
+
 		// Leave the 'sending' messages in local messages.
 		auto local = base::flat_set<not_null<HistoryItem*>>();
 		for (const auto &item : _clientSideMessages) {
@@ -4130,6 +4309,9 @@ HistoryBlock::HistoryBlock(not_null<History*> history)
 }
 
 int HistoryBlock::resizeGetHeight(int newWidth, ResizeRequest request) {
+	if (_deferredResize && request != ResizeRequest::ResizePending) {
+		request = std::min(request, *base::take(_deferredResize));
+	}
 	auto y = 0;
 	if (request == ResizeRequest::ReinitAll) {
 		for (const auto &message : messages) {
@@ -4154,6 +4336,12 @@ int HistoryBlock::resizeGetHeight(int newWidth, ResizeRequest request) {
 	return _height;
 }
 
+void HistoryBlock::deferResize(ResizeRequest request) {
+	_deferredResize = _deferredResize
+		? std::min(*_deferredResize, request)
+		: request;
+}
+
 void HistoryBlock::remove(not_null<Element*> view) {
 	Expects(view->block() == this);
 
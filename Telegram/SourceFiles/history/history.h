@@ -36,6 +36,7 @@ struct SponsoredFrom;
 class SponsoredMessages;
 class HistoryMessages;
 class SavedMessages;
+struct MessagesMemoryUsage;
 } // namespace Data
 
 namespace Dialogs {
@@ -193,6 +194,17 @@ public:
 	void addOlderSlice(const QVector<MTPMessage> &slice);
 	void addNewerSlice(const QVector<MTPMessage> &slice);
 
+	// A slice read from the local history cache is only shown in blocks,
+	// it doesn't touch shared media, last message or unread state.
+	// The first fresh server slice replaces it with dropCachedSlice(),
+	// an empty fresh slice destroys all the messages known only from cache.
+	void addCachedSlice(const QVector<MTPMessage> &slice);
+	void dropCachedSlice(const QVector<MTPMessage> &fresh);
+	[[nodiscard]] bool hasCachedSlice() const;
+	[[nodiscard]] bool isCachedSliceItem(MsgId id) const;
+
+	void collectMemoryUsage(Data::MessagesMemoryUsage &usage) const;
+
 	void newItemAdded(not_null<HistoryItem*> item);
 
 	void registerClientSideMessage(not_null<HistoryItem*> item);
@@ -274,7 +286,10 @@ public:
 	MsgId msgIdForRead() const;
 	HistoryItem *lastEditableMessage() const;
 
+	// Only the blocks around the scroll position are laid out when the
+	// width changes, others keep their old heights until they are shown.
 	void resizeToWidth(int newWidth);
+	[[nodiscard]] bool resizeDeferredBlocks(int top, int bottom);
 	void forceFullResize();
 	int height() const;
 
@@ -506,6 +521,8 @@ private:
 	// scrollTopOffset is undefined
 	void getNextScrollTopItem(HistoryBlock *block, int32 i);
 
+	[[nodiscard]] std::pair<int, int> countEagerResizeBlocks() const;
+
 	// helper method for countScrollState(int top)
 	[[nodiscard]] Element *findScrollTopItem(int top) const;
 
@@ -643,6 +660,8 @@ private:
 	std::optional<HistoryItem*> _lastServerMessage;
 	base::flat_set<not_null<HistoryItem*>> _clientSideMessages;
 	std::unordered_set<std::unique_ptr<HistoryItem>> _items;
+	base::flat_set<MsgId> _cachedSliceIds;
+	bool _cachedSliceShown = false;
 
 	std::unique_ptr<Data::HistoryMessages> _messages;
 	std::unique_ptr<HistoryStreamedDrafts> _streamedDrafts;
@@ -700,6 +719,10 @@ public:
 	void refreshView(not_null<Element*> view);
 
 	int resizeGetHeight(int newWidth, ResizeRequest request);
+	void deferResize(ResizeRequest request);
+	[[nodiscard]] bool resizeDeferred() const {
+		return _deferredResize.has_value();
+	}
 	int y() const {
 		return _y;
 	}
@@ -744,5 +767,6 @@ protected:
 	int _y = 0;
 	int _height = 0;
 	int _indexInHistory = -1;
+	std::optional<ResizeRequest> _deferredResize;
 
 };
@@ -3631,6 +3631,25 @@ bool HistoryInner::wasSelectedText() const {
 	return _wasSelectedText;
 }
 
+bool HistoryInner::resizeDeferredBlocks(int top, int bottom) {
+	// Lay out a screen above and below as well, to not jump on scroll.
+	const auto skip = bottom - top;
+	auto result = false;
+	if (const auto htop = historyTop(); htop >= 0) {
+		result = _history->resizeDeferredBlocks(
+			top - skip - htop,
+			bottom + skip - htop);
+	}
+	if (const auto mtop = migratedTop(); mtop >= 0) {
+		if (_migrated->resizeDeferredBlocks(
+				top - skip - mtop,
+				bottom + skip - mtop)) {
+			result = true;
+		}
+	}
+	return result;
+}
+
 void HistoryInner::visibleAreaUpdated(int top, int bottom) {
 	auto scrolledUp = (top < _visibleAreaTop);
 	_visibleAreaTop = top;
@@ -186,6 +186,7 @@ public:
 
 	// updates history->scrollTopItem/scrollTopOffset
 	void visibleAreaUpdated(int top, int bottom);
+	[[nodiscard]] bool resizeDeferredBlocks(int top, int bottom);
 
 	int historyHeight() const;
 	int historyScrollTop() const;
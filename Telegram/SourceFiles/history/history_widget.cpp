@@ -3106,6 +3106,14 @@ void HistoryWidget::clearAllLoadRequests() {
 		histories.cancelRequest(_firstLoadRequest);
 		_firstLoadRequest = 0;
 	}
+	if (_firstLoadFreshRequest) {
+		histories.cancelRequest(_firstLoadFreshRequest);
+		_firstLoadFreshRequest = 0;
+
+		// Without the fresh slice we can't tell which of the cached
+		// messages still exist, so forget all of them.
+		_history->dropCachedSlice({});
+	}
 	if (_preloadRequest) {
 		histories.cancelRequest(_preloadRequest);
 		_preloadRequest = 0;
@@ -3895,6 +3903,13 @@ void HistoryWidget::messagesFailed(const MTP::Error &error, int requestId) {
 	} else if (_firstLoadRequest == requestId) {
 		_firstLoadRequest = 0;
 		closeCurrent();
+	} else if (_firstLoadFreshRequest == requestId) {
+		_firstLoadFreshRequest = 0;
+
+		// Without the fresh slice we can't tell which of the cached
+		// messages still exist, so forget all of them and show again.
+		_history->dropCachedSlice({});
+		historyLoaded();
 	} else if (_delayedShowAtRequest == requestId) {
 		_delayedShowAtRequest = 0;
 	}
@@ -3914,6 +3929,8 @@ void HistoryWidget::messagesReceived(
 			_preloadDownRequest = 0;
 		} else if (_firstLoadRequest == requestId) {
 			_firstLoadRequest = 0;
+		} else if (_firstLoadFreshRequest == requestId) {
+			_firstLoadFreshRequest = 0;
 		} else if (_delayedShowAtRequest == requestId) {
 			_delayedShowAtRequest = 0;
 		}
@@ -3970,7 +3987,13 @@ void HistoryWidget::messagesReceived(
 		if (_history->loadedAtBottom()) {
 			checkActivation();
 		}
-	} else if (_firstLoadRequest == requestId) {
+	} else if (_firstLoadRequest == requestId
+		|| _firstLoadFreshRequest == requestId) {
+		if (_firstLoadFreshRequest == requestId) {
+			_firstLoadFreshRequest = 0;
+			_firstLoadRequest = -1; // hack - don't updateListSize yet
+			_history->dropCachedSlice(*histList);
+		}
 		if (toMigrated) {
 			_history->clear(History::ClearType::Unload);
 		} else if (_migrated) {
@@ -4062,6 +4085,7 @@ bool HistoryWidget::markingContentsRead() const {
 		&& _list
 		&& _historyInited
 		&& !_firstLoadRequest
+		&& !_firstLoadFreshRequest
 		&& !_delayedShowAtRequest
 		&& !_showAnimation
 		&& controller()->widget()->markingAsRead();
@@ -4082,6 +4106,7 @@ void HistoryWidget::firstLoadMessages() {
 	auto offsetId = MsgId();
 	auto offset = 0;
 	auto loadCount = kMessagesPerPage;
+	auto atTheEnd = false;
 	if (_showAtMsgId == ShowAtUnreadMsgId) {
 		if (const auto around = _migrated ? _migrated->loadAroundId() : 0) {
 			_history->getReadyFor(_showAtMsgId);
@@ -4094,10 +4119,12 @@ void HistoryWidget::firstLoadMessages() {
 			offsetId = around;
 		} else {
 			_history->getReadyFor(ShowAtTheEndMsgId);
+			atTheEnd = true;
 		}
 	} else if (_showAtMsgId == ShowAtTheEndMsgId) {
 		_history->getReadyFor(_showAtMsgId);
 		loadCount = kMessagesPerPageFirst;
+		atTheEnd = true;
 	} else if (_showAtMsgId > 0) {
 		_history->getReadyFor(_showAtMsgId);
 		offset = -loadCount / 2;
@@ -4121,7 +4148,11 @@ void HistoryWidget::firstLoadMessages() {
 	const auto history = from;
 	const auto type = Data::Histories::RequestType::History;
 	auto &histories = history->owner().histories();
-	_firstLoadRequest = histories.sendRequest(history, type, [=](
+
+	// After the cached slice is shown the request is moved from
+	// _firstLoadRequest to _firstLoadFreshRequest, so remember its id.
+	const auto requestId = std::make_shared<int>();
+	*requestId = _firstLoadRequest = histories.sendRequest(history, type, [=](
 			Fn<void()> finish) {
 		return history->session().api().request(MTPmessages_GetHistory(
 			history->peer->input(),
@@ -4133,13 +4164,40 @@ void HistoryWidget::firstLoadMessages() {
 			MTP_int(minId),
 			MTP_long(historyHash)
 		)).done([=](const MTPmessages_Messages &result) {
-			messagesReceived(history->peer, result, _firstLoadRequest);
+			if (atTheEnd) {
+				history->owner().histories().writeCachedSlice(
+					history,
+					result);
+			}
+			messagesReceived(history->peer, result, *requestId);
 			finish();
 		}).fail([=](const MTP::Error &error) {
-			messagesFailed(error, _firstLoadRequest);
+			messagesFailed(error, *requestId);
 			finish();
 		}).send();
 	});
+	if (atTheEnd && _history->isEmpty()) {
+		firstLoadCachedMessages(*requestId);
+	}
+}
+
+void HistoryWidget::firstLoadCachedMessages(int requestId) {
+	const auto history = _history;
+	auto &histories = history->owner().histories();
+	histories.readCachedSlice(history, crl::guard(this, [=](
+			const QVector<MTPMessage> &messages) {
+		if (_history != history
+			|| _firstLoadRequest != requestId
+			|| !history->isEmpty()) {
+			return;
+		}
+		history->addCachedSlice(messages);
+		if (history->isEmpty()) {
+			return;
+		}
+		_firstLoadFreshRequest = base::take(_firstLoadRequest);
+		historyLoaded();
+	}));
 }
 
 void HistoryWidget::loadMessages() {
@@ -4387,6 +4445,11 @@ void HistoryWidget::visibleAreaUpdated() {
 		const auto scrollTop = _scroll->scrollTop();
 		const auto scrollBottom = scrollTop + _scroll->height();
 		_list->visibleAreaUpdated(scrollTop, scrollBottom);
+		if (_historyInited
+			&& _list->resizeDeferredBlocks(scrollTop, scrollBottom)) {
+			// The scroll state was just counted, keep the items in place.
+			updateHistoryGeometry();
+		}
 		controller()->floatPlayerAreaUpdated();
 		session().data().itemVisibilitiesUpdated();
 	}
@@ -4417,6 +4480,7 @@ void HistoryWidget::preloadHistoryIfNeeded() {
 
 void HistoryWidget::preloadHistoryByScroll() {
 	if (_firstLoadRequest
+		|| _firstLoadFreshRequest
 		|| _delayedShowAtRequest
 		|| _scroll->isHidden()
 		|| !_peer
@@ -166,6 +166,7 @@ public:
 	void loadMessages();
 	void loadMessagesDown();
 	void firstLoadMessages();
+	void firstLoadCachedMessages(int requestId);
 	void delayedShowAt(MsgId showAtMsgId, const Window::SectionShow &params);
 
 	bool updateReplaceMediaButton();
@@ -766,6 +767,7 @@ private:
 	bool _showAndMaybeSendStart = false;
 
 	int _firstLoadRequest = 0; // Not real mtpRequestId.
+	int _firstLoadFreshRequest = 0; // Not real mtpRequestId.
 	int _preloadRequest = 0; // Not real mtpRequestId.
 	int _preloadDownRequest = 0; // Not real mtpRequestId.
 
@@ -32,6 +32,7 @@ https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
 #include "data/data_document_media.h"
 #include "data/data_file_click_handler.h"
 #include "data/data_file_origin.h"
+#include "data/data_memory_governor.h"
 #include "chat_helpers/stickers_lottie.h"
 #include "styles/style_chat.h"
 #include "styles/style_chat_helpers.h"
@@ -46,6 +47,9 @@ constexpr auto kPremiumMultiplier = (1 + 0.245 * 2);
 constexpr auto kEmojiMultiplier = 3;
 constexpr auto kMessageEffectMultiplier = 2;
 
+// Lottie and webm players keep a few decoded frames of the sticker size.
+constexpr auto kPlayerFramesInMemory = 4;
+
 [[nodiscard]] QImage CacheDiceImage(
 		const QString &emoji,
 		int index,
@@ -314,6 +318,9 @@ void Sticker::paintAnimationFrame(
 		: PowerSaving::kStickersChat;
 	const auto paused = context.paused
 		|| (_diceIndex < 0 && On(powerSavingFlag));
+	if (_playerMemory) {
+		_playerMemory->touch();
+	}
 	const auto frame = _player
 		? _player->frame(
 			_size,
@@ -642,6 +649,18 @@ void Sticker::playerCreated() {
 
 	_parent->history()->owner().registerHeavyViewPart(_parent);
 	_player->setRepaintCallback([=] { _parent->customEmojiRepaint(); });
+	_playerMemory = std::make_unique<Data::MemoryHolder>(
+		Data::MemoryHolderDescriptor{
+			.category = Data::MemoryCategory::Animations,
+			.bytes = [=] { return playerMemoryBytes(); },
+			.unload = [=](Data::MemoryPriority) { unloadPlayer(); },
+		});
+}
+
+int64 Sticker::playerMemoryBytes() const {
+	const auto ratio = style::DevicePixelRatio();
+	return int64(_size.width()) * _size.height() * ratio * ratio * 4
+		* kPlayerFramesInMemory;
 }
 
 bool Sticker::hasHeavyPart() const {
@@ -661,6 +680,7 @@ void Sticker::unloadPlayer() {
 		_nextLastFrame = false;
 		_oncePlayed = false;
 	}
+	_playerMemory = nullptr;
 	_player = nullptr;
 	if (hasPremiumEffect()) {
 		_parent->delegate()->elementCancelPremium(_parent);
@@ -671,9 +691,11 @@ void Sticker::unloadPlayer() {
 std::unique_ptr<StickerPlayer> Sticker::stickerTakePlayer(
 		not_null<DocumentData*> data,
 		const Lottie::ColorReplacements *replacements) {
-	return (data == _data && replacements == _replacements)
-		? std::move(_player)
-		: nullptr;
+	if (data != _data || replacements != _replacements) {
+		return nullptr;
+	}
+	_playerMemory = nullptr;
+	return std::move(_player);
 }
 
 } // namespace HistoryView
@@ -18,6 +18,7 @@ class Session;
 namespace Data {
 struct FileOrigin;
 class DocumentMedia;
+class MemoryHolder;
 } // namespace Data
 
 namespace Lottie {
@@ -123,6 +124,7 @@ private:
 	void setupPlayer();
 	void playerCreated();
 	void unloadPlayer();
+	[[nodiscard]] int64 playerMemoryBytes() const;
 	void emojiStickerClicked();
 	void premiumStickerClicked();
 	void checkPremiumEffectStart();
@@ -131,6 +133,7 @@ private:
 	const not_null<DocumentData*> _data;
 	const Lottie::ColorReplacements *_replacements = nullptr;
 	std::unique_ptr<StickerPlayer> _player;
+	std::unique_ptr<Data::MemoryHolder> _playerMemory;
 	mutable std::shared_ptr<Data::DocumentMedia> _dataMedia;
 	ClickHandlerPtr _link;
 	QSize _size;
@@ -211,19 +211,9 @@ Session::Session(
 
 		// Storage::Account uses Main::Account::session() in those methods.
 		// So they can't be called during Main::Session construction.
-		local().readInstalledStickers();
-		local().readInstalledMasks();
-		local().readInstalledCustomEmoji();
-		local().readFeaturedStickers();
-		local().readFeaturedCustomEmoji();
-		local().readRecentStickers();
-		local().readRecentMasks();
-		local().readFavedStickers();
-		local().readSavedGifs();
+		local().readStartStickers();
 		data().stickers().notifyUpdated(Data::StickersType::Stickers);
-		data().stickers().notifyUpdated(Data::StickersType::Masks);
 		data().stickers().notifyUpdated(Data::StickersType::Emoji);
-		data().stickers().notifySavedGifsUpdated();
 		DEBUG_LOG(("Init: Account stored data load finished."));
 	});
 
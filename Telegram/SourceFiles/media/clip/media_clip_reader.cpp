@@ -12,6 +12,7 @@ https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
 #include "ui/chat/attach/attach_prepare.h"
 #include "ui/painter.h"
 #include "core/file_location.h"
+#include "data/data_memory_governor.h"
 #include "base/random.h"
 #include "base/invoke_queued.h"
 #include "logs.h"
@@ -218,6 +219,19 @@ void Reader::init(const Core::FileLocation &location, const QByteArray &data) {
 		}
 	}
 	Workers[_threadIndex]->manager.append(this, location, data);
+
+	// Accounted only, the frames are owned by the worker threads as well.
+	using Descriptor = Data::MemoryHolderDescriptor;
+	_memory = std::make_unique<Data::MemoryHolder>(Descriptor{
+		.category = Data::MemoryCategory::Animations,
+		.bytes = [=] { return framesMemoryBytes(); },
+	});
+}
+
+int64 Reader::framesMemoryBytes() const {
+	// Each of the three frames has the original and the prepared images.
+	constexpr auto kImagesCount = 3 * 2;
+	return int64(_width) * _height * 4 * kImagesCount;
 }
 
 Reader::Frame *Reader::frameToShow(int32 *index) const { // 0 means not ready
@@ -330,6 +344,8 @@ Reader::FrameInfo Reader::frameInfo(FrameRequest request, crl::time now) {
 		? request.outer
 		: request.frame).isEmpty());
 
+	_memory->touch();
+
 	const auto frame = frameToShow();
 	Assert(frame != nullptr);
 
@@ -20,6 +20,10 @@ namespace Core {
 class FileLocation;
 } // namespace Core
 
+namespace Data {
+class MemoryHolder;
+} // namespace Data
+
 namespace Media {
 namespace Clip {
 
@@ -135,6 +139,7 @@ public:
 
 private:
 	void init(const Core::FileLocation &location, const QByteArray &data);
+	[[nodiscard]] int64 framesMemoryBytes() const;
 
 	Callback _callback;
 	State _state = State::Reading;
@@ -178,6 +183,7 @@ private:
 	friend class Manager;
 
 	ReaderPrivate *_private = nullptr;
+	std::unique_ptr<Data::MemoryHolder> _memory;
 
 };
 
@@ -32,6 +32,20 @@ constexpr auto kMaxQueuedPackets = 1024;
 		).split(QChar(',')).contains(u"webm");
 }
 
+[[nodiscard]] std::vector<int64> KeyframePositions(
+		not_null<AVStream*> stream) {
+	const auto count = avformat_index_get_entries_count(stream);
+	auto result = std::vector<int64>();
+	result.reserve(std::max(count, 0));
+	for (auto i = 0; i < count; ++i) {
+		const auto entry = avformat_index_get_entry(stream, i);
+		if (entry && (entry->flags & AVINDEX_KEYFRAME) && entry->pos >= 0) {
+			result.push_back(entry->pos);
+		}
+	}
+	return result;
+}
+
 } // namespace
 
 File::Context::Context(
@@ -324,6 +338,9 @@ void File::Context::start(StartOptions options) {
 	if (unroll()) {
 		return;
 	}
+	if (video.codec && _reader->isRemoteLoader()) {
+		startPrefetch(format.get(), video);
+	}
 
 	if (video.codec) {
 		_queuedPackets[video.index].reserve(kMaxQueuedPackets);
@@ -339,6 +356,18 @@ void File::Context::start(StartOptions options) {
 	_format = std::move(format);
 }
 
+void File::Context::startPrefetch(
+		not_null<AVFormatContext*> format,
+		const Stream &video) {
+	const auto bitrate = (video.duration > 0
+		&& video.duration != kDurationUnavailable)
+		? (_size * 1000 / video.duration)
+		: int64(0);
+	_reader->setPrefetchOffsets(
+		KeyframePositions(format->streams[video.index]),
+		bitrate);
+}
+
 void File::Context::sendFullInCache(bool force) {
 	const auto started = _fullInCache.has_value();
 	if (force || started) {
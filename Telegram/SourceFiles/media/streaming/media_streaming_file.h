@@ -91,6 +91,9 @@ private:
 			not_null<AVFormatContext *> format,
 			const Stream &stream,
 			crl::time position);
+		void startPrefetch(
+			not_null<AVFormatContext *> format,
+			const Stream &video);
 
 		// TODO base::expected.
 		[[nodiscard]] auto readPacket()
@@ -27,13 +27,82 @@ constexpr auto kSlicesInMemory = 2;
 constexpr auto kPreloadPartsAhead = 8;
 constexpr auto kDownloaderRequestsLimit = 4;
 
-using PartsMap = base::flat_map<uint32, QByteArray>;
+// Keyframe parts are prefetched only when nothing else is requested.
+constexpr auto kPrefetchPartsPerKeyframe = 2;
+constexpr auto kPrefetchKeyframesAhead = 64;
+constexpr auto kPrefetchRequestsLimit = 4;
+constexpr auto kPrefetchPartsInMemory = 128;
+
+using PartsMap = base::flat_map<uint32, SlicePart>;
 
 struct ParsedCacheEntry {
 	PartsMap parts;
 	std::optional<PartsMap> included;
 };
 
+SlicePart PartFromBuffer(
+		const QByteArray &buffer,
+		bytes::const_span part) {
+	const auto from = reinterpret_cast<const char*>(part.data())
+		- buffer.constData();
+	return SlicePart(buffer, uint32(from), uint32(part.size()));
+}
+
+void AppendPart(QByteArray &to, const QByteArray &part) {
+	to.append(part);
+}
+
+void AppendPart(QByteArray &to, const SlicePart &part) {
+	const auto bytes = part.data();
+	to.append(reinterpret_cast<const char*>(bytes.data()), bytes.size());
+}
+
+template <typename Map> // Map::mapped_type is QByteArray or SlicePart.
+QByteArray SerializeComplexParts(const Map &parts) {
+	auto result = QByteArray();
+	const auto count = parts.size();
+	const auto intSize = sizeof(int32);
+	result.reserve(count * kPartSize + 2 * intSize * (count + 1));
+	const auto appendInt = [&](int value) {
+		auto serialized = int32(value);
+		result.append(
+			reinterpret_cast<const char*>(&serialized),
+			intSize);
+	};
+	appendInt(count);
+	for (const auto &[offset, part] : parts) {
+		appendInt(offset);
+		appendInt(part.size());
+		AppendPart(result, part);
+	}
+	return result;
+}
+
+// Parts are continuous, if they all still lie in one buffer read
+// from cache we put it back as is, without copying.
+QByteArray SerializeContinuousParts(const PartsMap &parts) {
+	Expects(!parts.empty());
+
+	const auto &buffer = parts.front().second.buffer();
+	auto from = uint32();
+	const auto shared = ranges::all_of(parts, [&](const auto &pair) {
+		const auto &part = pair.second;
+		const auto good = (part.buffer().constData() == buffer.constData())
+			&& (part.from() == from);
+		from += part.size();
+		return good;
+	});
+	if (shared && !buffer.isEmpty() && from == buffer.size()) {
+		return buffer;
+	}
+	auto result = QByteArray();
+	result.reserve(parts.size() * kPartSize);
+	for (const auto &[offset, part] : parts) {
+		AppendPart(result, part);
+	}
+	return result;
+}
+
 bool IsContiguousSerialization(int serializedSize, int maxSliceSize) {
 	return !(serializedSize % kPartSize) || (serializedSize == maxSliceSize);
 }
@@ -72,6 +141,7 @@ int MaxSliceSize(int sliceNumber, uint32 size) {
 
 bytes::const_span ParseComplexCachedMap(
 		PartsMap &result,
+		const QByteArray &buffer,
 		bytes::const_span data,
 		int maxSize) {
 	const auto takeInt = [&]() -> std::optional<uint32> {
@@ -110,16 +180,14 @@ bytes::const_span ParseComplexCachedMap(
 			|| bytes.size() != size) {
 			return {};
 		}
-		result.try_emplace(
-			offset,
-			reinterpret_cast<const char*>(bytes.data()),
-			bytes.size());
+		result.try_emplace(offset, PartFromBuffer(buffer, bytes));
 	}
 	return data;
 }
 
 bytes::const_span ParseCachedMap(
 		PartsMap &result,
+		const QByteArray &buffer,
 		bytes::const_span data,
 		int maxSize) {
 	const auto size = int(data.size());
@@ -131,33 +199,35 @@ bytes::const_span ParseCachedMap(
 			const auto part = data.subspan(
 				offset,
 				std::min(kPartSize, size - offset));
-			result.try_emplace(
-				uint32(offset),
-				reinterpret_cast<const char*>(part.data()),
-				part.size());
+			result.try_emplace(uint32(offset), PartFromBuffer(buffer, part));
 		}
 		return {};
 	}
-	return ParseComplexCachedMap(result, data, maxSize);
+	return ParseComplexCachedMap(result, buffer, data, maxSize);
 }
 
 ParsedCacheEntry ParseCacheEntry(
-		bytes::const_span data,
+		const QByteArray &buffer,
 		int sliceNumber,
 		int64 size) {
 	auto result = ParsedCacheEntry();
 	const auto remaining = ParseCachedMap(
 		result.parts,
-		data,
+		buffer,
+		bytes::make_span(buffer),
 		MaxSliceSize(sliceNumber, size));
 	if (!sliceNumber && ComputeIsGoodHeader(size, result.parts)) {
 		result.included = PartsMap();
-		ParseCachedMap(*result.included, remaining, MaxSliceSize(1, size));
+		ParseCachedMap(
+			*result.included,
+			buffer,
+			remaining,
+			MaxSliceSize(1, size));
 	}
 	return result;
 }
 
-template <typename Range> // Range::value_type is Pair<int, QByteArray>
+template <typename Range> // Range::value_type is Pair<int, SlicePart>
 uint32 FindNotLoadedStart(Range &&parts, uint32 offset) {
 	auto result = offset;
 	for (const auto &part : parts) {
@@ -172,7 +242,7 @@ uint32 FindNotLoadedStart(Range &&parts, uint32 offset) {
 	return result;
 }
 
-template <typename Range> // Range::value_type is Pair<uint32, QByteArray>
+template <typename Range> // Range::value_type is Pair<uint32, SlicePart>
 void CopyLoaded(
 		bytes::span buffer,
 		Range &&parts,
@@ -180,7 +250,7 @@ void CopyLoaded(
 		uint32 till) {
 	auto filled = offset;
 	for (const auto &part : parts) {
-		const auto bytes = bytes::make_span(part.second);
+		const auto bytes = part.second.data();
 		const auto partStart = part.first;
 		const auto partEnd = uint32(partStart + bytes.size());
 		const auto copyTill = std::min(partEnd, till);
@@ -196,6 +266,48 @@ void CopyLoaded(
 
 } // namespace
 
+SlicePart::SlicePart(QByteArray bytes)
+: _buffer(std::move(bytes))
+, _size(_buffer.size()) {
+}
+
+SlicePart::SlicePart(QByteArray buffer, uint32 from, uint32 size)
+: _buffer(std::move(buffer))
+, _from(from)
+, _size(size) {
+	Expects(_from + _size <= _buffer.size());
+}
+
+bytes::const_span SlicePart::data() const {
+	return bytes::make_span(_buffer).subspan(_from, _size);
+}
+
+uint32 SlicePart::size() const {
+	return _size;
+}
+
+QByteArray SlicePart::toByteArray() const {
+	return wholeBuffer()
+		? _buffer
+		: QByteArray(_buffer.constData() + _from, _size);
+}
+
+SlicePart SlicePart::detached() const {
+	return wholeBuffer() ? *this : SlicePart(toByteArray());
+}
+
+const QByteArray &SlicePart::buffer() const {
+	return _buffer;
+}
+
+uint32 SlicePart::from() const {
+	return _from;
+}
+
+bool SlicePart::wholeBuffer() const {
+	return !_from && (_size == _buffer.size());
+}
+
 template <int Size>
 bool Reader::StackIntVector<Size>::add(uint32 value) {
 	using namespace rpl::mappers;
@@ -259,10 +371,11 @@ void Reader::Slice::processCacheData(PartsMap &&data) {
 	}
 }
 
-void Reader::Slice::addPart(uint32 offset, QByteArray bytes) {
+void Reader::Slice::addPart(uint32 offset, SlicePart part) {
 	Expects(!parts.contains(offset));
 
-	parts.emplace(offset, std::move(bytes));
+	parts.emplace(offset, std::move(part));
+	flags &= ~Flag::EmptyInCache;
 	if (flags & Flag::LoadedFromCache) {
 		flags |= Flag::ChangedSinceCache;
 	}
@@ -418,9 +531,7 @@ void Reader::Slices::applyHeaderCacheData() {
 			if (!predicate(index)) {
 				break;
 			}
-			_data[index].addPart(
-				offset - index * kInSlice,
-				base::duplicate(part));
+			_data[index].addPart(offset - index * kInSlice, part);
 		}
 	};
 	if (_header.parts.empty()) {
@@ -486,6 +597,8 @@ void Reader::Slices::processCachedSizes(const std::vector<int> &sizes) {
 		} else if (loaded) {
 			_data[i].flags |= Flag::FullInCache;
 			++loadedCount;
+		} else if (!sizes[i] && _data[i].parts.empty()) {
+			_data[i].flags |= Flag::EmptyInCache;
 		}
 	}
 	_fullInCache = (loadedCount == count);
@@ -533,7 +646,7 @@ void Reader::Slices::processPart(
 	Expects(isFullInHeader() || (offset / kInSlice < _data.size()));
 
 	if (isFullInHeader()) {
-		_header.addPart(offset, bytes);
+		_header.addPart(offset, SlicePart(std::move(bytes)));
 		checkSliceFullLoaded(0);
 		return;
 	//} else if (_headerMode == HeaderMode::Unknown) {
@@ -544,7 +657,9 @@ void Reader::Slices::processPart(
 	//	}
 	}
 	const auto index = offset / kInSlice;
-	_data[index].addPart(offset - index * kInSlice, std::move(bytes));
+	_data[index].addPart(
+		offset - index * kInSlice,
+		SlicePart(std::move(bytes)));
 	checkSliceFullLoaded(index + 1);
 }
 
@@ -605,7 +720,8 @@ auto Reader::Slices::fill(uint32 offset, bytes::span buffer) -> FillResult {
 				const auto totalOffset = slice * kInSlice + part.first;
 				if (!_header.parts.contains(totalOffset)
 					&& _header.parts.size() < kMaxPartsInHeader) {
-					_header.addPart(totalOffset, part.second);
+					// Don't hold the whole cached slice buffer in header.
+					_header.addPart(totalOffset, part.second.detached());
 				}
 			}
 		}
@@ -677,14 +793,44 @@ QByteArray Reader::Slices::partForDownloader(uint32 offset) const {
 	Expects(offset < _size);
 
 	if (const auto i = _header.parts.find(offset); i != end(_header.parts)) {
-		return i->second;
+		return i->second.toByteArray();
 	} else if (isFullInHeader()) {
 		return QByteArray();
 	}
 	const auto index = offset / kInSlice;
 	const auto &slice = _data[index];
 	const auto i = slice.parts.find(offset - index * kInSlice);
-	return (i != end(slice.parts)) ? i->second : QByteArray();
+	return (i != end(slice.parts)) ? i->second.toByteArray() : QByteArray();
+}
+
+bool Reader::Slices::prefetchRequired(uint32 offset) const {
+	Expects(offset < _size);
+
+	using Flag = Slice::Flag;
+	if (isFullInHeader()) {
+		return false;
+	}
+	const auto index = offset / kInSlice;
+	const auto &slice = _data[index];
+
+	// If the slice has something in cache and was not read from it
+	// we don't know which parts are there, so we don't prefetch them.
+	return !(slice.flags & Flag::FullInCache)
+		&& ((_headerMode == HeaderMode::NoCache)
+			|| (slice.flags & (Flag::LoadedFromCache | Flag::EmptyInCache)))
+		&& !slice.parts.contains(offset - index * kInSlice);
+}
+
+bool Reader::Slices::partInMemory(uint32 offset) const {
+	Expects(offset < _size);
+
+	if (_header.parts.contains(offset)) {
+		return true;
+	} else if (isFullInHeader()) {
+		return false;
+	}
+	const auto index = offset / kInSlice;
+	return _data[index].parts.contains(offset - index * kInSlice);
 }
 
 bool Reader::Slices::waitingForHeaderCache() const {
@@ -781,10 +927,7 @@ Reader::SerializedSlice Reader::Slices::serializeAndUnloadSlice(
 	const auto continuous = (continuousTill > slice.parts.back().first);
 	if (continuous) {
 		// All data is continuous.
-		result.data.reserve(count * kPartSize);
-		for (const auto &[offset, part] : slice.parts) {
-			result.data.append(part);
-		}
+		result.data = SerializeContinuousParts(slice.parts);
 	} else {
 		result.data = serializeComplexSlice(slice);
 		if (writeHeaderAndSlice) {
@@ -818,7 +961,7 @@ void Reader::Slices::unloadSlice(Slice &slice) const {
 }
 
 QByteArray Reader::Slices::serializeComplexSlice(const Slice &slice) const {
-	return SerializeComplexPartsMap(slice.parts);
+	return SerializeComplexParts(slice.parts);
 }
 
 QByteArray Reader::Slices::serializeAndUnloadFirstSliceNoHeader() {
@@ -855,6 +998,7 @@ Reader::Reader(
 : _loader(std::move(loader))
 , _cache(cache)
 , _cacheHelper(cache ? InitCacheHelper(_loader->baseCacheKey()) : nullptr)
+, _prefetchBudget(kPrefetchPartsInMemory)
 , _slices(_loader->size(), _cacheHelper != nullptr) {
 	_loader->parts(
 	) | rpl::on_next([=](LoadedPart &&part) {
@@ -870,6 +1014,15 @@ Reader::Reader(
 		}
 	}, _lifetime);
 
+	_loader->speedEstimate(
+	) | rpl::on_next([=](SpeedEstimate estimate) {
+		if (!estimate.unreliable) {
+			_loaderBytesPerSecond.store(
+				estimate.bytesPerSecond,
+				std::memory_order_relaxed);
+		}
+	}, _lifetime);
+
 	if (_cacheHelper) {
 		readFromCache(0);
 	}
@@ -922,6 +1075,7 @@ void Reader::stopStreaming(bool stillActive) {
 		_streamingActive = false;
 		refreshLoaderPriority();
 		_loadingOffsets.clear();
+		_prefetchLoading.clear();
 		processDownloaderRequests();
 	}
 }
@@ -1022,7 +1176,7 @@ void Reader::checkForDownloaderReadyOffsets() {
 		if (j == end(*i->second)) {
 			return true;
 		}
-		return unavailableInBytes(offset, std::move(j->second));
+		return unavailableInBytes(offset, j->second.toByteArray());
 	};
 	const auto unavailable = [&](uint32 offset) {
 		return unavailableInBytes(offset, _slices.partForDownloader(offset))
@@ -1160,7 +1314,7 @@ void Reader::readFromCache(int sliceNumber) {
 			sizes = std::move(sizes)
 		]() mutable{
 			auto entry = ParseCacheEntry(
-				bytes::make_span(result),
+				result,
 				sliceNumber,
 				size);
 			if (const auto strong = cache.lock()) {
@@ -1228,6 +1382,30 @@ bool Reader::fullInCache() const {
 	return _slices.fullInCache();
 }
 
+void Reader::setPrefetchOffsets(
+		std::vector<int64> offsets,
+		int64 contentBytesPerSecond) {
+	const auto size = this->size();
+	_prefetchOffsets.clear();
+	_prefetchOffsets.reserve(offsets.size());
+	for (const auto offset : offsets) {
+		if (offset >= 0 && offset < size) {
+			_prefetchOffsets.push_back(uint32(offset));
+		}
+	}
+	ranges::sort(_prefetchOffsets);
+	_prefetchOffsets.erase(
+		ranges::unique(_prefetchOffsets),
+		end(_prefetchOffsets));
+	_contentBytesPerSecond = contentBytesPerSecond;
+}
+
+void Reader::setPrefetchBudget(int parts) {
+	Expects(parts >= 0);
+
+	_prefetchBudget.store(parts, std::memory_order_relaxed);
+}
+
 Reader::FillState Reader::fill(
 		int64 offset,
 		bytes::span buffer,
@@ -1304,13 +1482,67 @@ Reader::FillState Reader::fillFromSlices(uint32 offset, bytes::span buffer) {
 		}
 		loadAtOffset(offset);
 	}
+	if (result.state == FillState::Success && checkPriority) {
+		// Nothing is required for the playback window right now.
+		prefetchAfter(offset);
+	}
 	return result.state;
 }
 
+void Reader::prefetchAfter(uint32 offset) {
+	if (_prefetchOffsets.empty()
+		|| _prefetchLoading.size() >= kPrefetchRequestsLimit) {
+		return;
+	}
+
+	// Prefetched parts that were already read or unloaded with their
+	// slices don't take memory from the prefetch budget anymore.
+	for (auto i = begin(_prefetchLoaded); i != end(_prefetchLoaded);) {
+		if (*i <= offset || !_slices.partInMemory(*i)) {
+			i = _prefetchLoaded.erase(i);
+		} else {
+			++i;
+		}
+	}
+	const auto inMemory = [&] {
+		return int(_prefetchLoading.size() + _prefetchLoaded.size());
+	};
+	const auto budget = _prefetchBudget.load(std::memory_order_relaxed);
+	const auto speed = _loaderBytesPerSecond.load(std::memory_order_relaxed);
+	if (inMemory() >= budget
+		|| (_contentBytesPerSecond
+			&& 2 * int64(speed) < 3 * _contentBytesPerSecond)) {
+		return;
+	}
+	const auto size = uint32(this->size());
+	const auto from = ranges::upper_bound(_prefetchOffsets, offset);
+	const auto till = from + std::min(
+		int(end(_prefetchOffsets) - from),
+		kPrefetchKeyframesAhead);
+	for (const auto keyframe : ranges::make_subrange(from, till)) {
+		const auto first = (keyframe / kPartSize) * kPartSize;
+		for (auto i = 0; i != kPrefetchPartsPerKeyframe; ++i) {
+			const auto part = uint32(first + i * kPartSize);
+			if (part >= size || !_slices.prefetchRequired(part)) {
+				continue;
+			} else if (!_loadingOffsets.add(part)) {
+				continue;
+			}
+			_prefetchLoading.emplace(part);
+			_loader->load(part);
+			if (_prefetchLoading.size() >= kPrefetchRequestsLimit
+				|| inMemory() >= budget) {
+				return;
+			}
+		}
+	}
+}
+
 void Reader::cancelLoadInRange(uint32 from, uint32 till) {
 	Expects(from < till);
 
 	for (const auto offset : _loadingOffsets.takeInRange(from, till)) {
+		_prefetchLoading.remove(offset);
 		if (!_downloaderOffsetsRequested.contains(offset)) {
 			_loader->cancel(offset);
 		}
@@ -1374,6 +1606,9 @@ bool Reader::processLoadedParts() {
 		} else if (!_loadingOffsets.remove(part.offset)) {
 			continue;
 		}
+		if (_prefetchLoading.remove(part.offset)) {
+			_prefetchLoaded.emplace(part.offset);
+		}
 		_slices.processPart(
 			part.offset,
 			std::move(part.bytes));
@@ -1412,23 +1647,7 @@ Reader::~Reader() {
 
 QByteArray SerializeComplexPartsMap(
 		const base::flat_map<uint32, QByteArray> &parts) {
-	auto result = QByteArray();
-	const auto count = parts.size();
-	const auto intSize = sizeof(int32);
-	result.reserve(count * kPartSize + 2 * intSize * (count + 1));
-	const auto appendInt = [&](int value) {
-		auto serialized = int32(value);
-		result.append(
-			reinterpret_cast<const char*>(&serialized),
-			intSize);
-	};
-	appendInt(count);
-	for (const auto &[offset, part] : parts) {
-		appendInt(offset);
-		appendInt(part.size());
-		result.append(part);
-	}
-	return result;
+	return SerializeComplexParts(parts);
 }
 
 } // namespace Streaming
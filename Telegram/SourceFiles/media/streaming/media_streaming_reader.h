@@ -31,6 +31,33 @@ class Loader;
 struct LoadedPart;
 enum class Error;
 
+// A part of an implicitly shared buffer, so that a slice read from cache
+// lives in a single allocation and can be put back to cache as is.
+class SlicePart final {
+public:
+	SlicePart() = default;
+	explicit SlicePart(QByteArray bytes);
+	SlicePart(QByteArray buffer, uint32 from, uint32 size);
+
+	[[nodiscard]] bytes::const_span data() const;
+	[[nodiscard]] uint32 size() const;
+
+	// Both share the buffer if the part covers it whole.
+	[[nodiscard]] QByteArray toByteArray() const;
+	[[nodiscard]] SlicePart detached() const;
+
+	[[nodiscard]] const QByteArray &buffer() const;
+	[[nodiscard]] uint32 from() const;
+
+private:
+	[[nodiscard]] bool wholeBuffer() const;
+
+	QByteArray _buffer;
+	uint32 _from = 0;
+	uint32 _size = 0;
+
+};
+
 class Reader final : public base::has_weak_ptr {
 public:
 	enum class FillState : uchar {
@@ -61,7 +88,14 @@ public:
 	[[nodiscard]] int headerSize() const;
 	[[nodiscard]] bool fullInCache() const;
 
+	// Byte offsets of keyframes, their parts are loaded ahead of reading
+	// while the loader is fast enough for the content bitrate.
+	void setPrefetchOffsets(
+		std::vector<int64> offsets,
+		int64 contentBytesPerSecond);
+
 	// Thread safe.
+	void setPrefetchBudget(int parts);
 	void startSleep(not_null<crl::semaphore*> wake);
 	void wakeFromSleep();
 	void stopSleep();
@@ -90,7 +124,7 @@ private:
 
 	// FileSize: Right now any file size fits 32 bit.
 
-	using PartsMap = base::flat_map<uint32, QByteArray>;
+	using PartsMap = base::flat_map<uint32, SlicePart>;
 
 	template <int Size>
 	class StackIntVector {
@@ -121,6 +155,7 @@ private:
 			LoadedFromCache = 0x02,
 			ChangedSinceCache = 0x04,
 			FullInCache = 0x08,
+			EmptyInCache = 0x10,
 		};
 		friend constexpr inline bool is_flag_type(Flag) { return true; }
 		using Flags = base::flags<Flag>;
@@ -133,7 +168,7 @@ private:
 		};
 
 		void processCacheData(PartsMap &&data);
-		void addPart(uint32 offset, QByteArray bytes);
+		void addPart(uint32 offset, SlicePart part);
 		PrepareFillResult prepareFill(uint32 from, uint32 till);
 
 		// Get up to kLoadFromRemoteMax not loaded parts in from-till range.
@@ -169,6 +204,8 @@ private:
 		[[nodiscard]] SerializedSlice unloadToCache();
 
 		[[nodiscard]] QByteArray partForDownloader(uint32 offset) const;
+		[[nodiscard]] bool prefetchRequired(uint32 offset) const;
+		[[nodiscard]] bool partInMemory(uint32 offset) const;
 		[[nodiscard]] bool readCacheForDownloaderRequired(uint32 offset);
 
 	private:
@@ -221,6 +258,7 @@ private:
 	bool checkForSomethingMoreReceived();
 
 	FillState fillFromSlices(uint32 offset, bytes::span buffer);
+	void prefetchAfter(uint32 offset);
 
 	void finalizeCache();
 
@@ -251,6 +289,13 @@ private:
 	std::atomic<bool> _stopStreamingAsync = false;
 	PriorityQueue _loadingOffsets;
 
+	std::vector<uint32> _prefetchOffsets;
+	base::flat_set<uint32> _prefetchLoading;
+	base::flat_set<uint32> _prefetchLoaded;
+	int64 _contentBytesPerSecond = 0;
+	std::atomic<int> _prefetchBudget = 0;
+	std::atomic<int> _loaderBytesPerSecond = 0;
+
 	Slices _slices;
 
 	// Even if streaming had failed, the Reader can work for the downloader.
@@ -11,6 +11,7 @@ https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
 #include "ui/image/image_prepare.h"
 #include "ui/painter.h"
 #include "ffmpeg/ffmpeg_utility.h"
+#include "ffmpeg/ffmpeg_yuv_convert.h"
 
 namespace Media {
 namespace Streaming {
@@ -174,6 +175,9 @@ QImage ConvertFrame(
 			to += deltaTo;
 			from += deltaFrom;
 		}
+	} else if (frameSize == storage.size()
+		&& FFmpeg::Yuv420ToBgraSupported(frame)) {
+		FFmpeg::Yuv420ToBgra(frame, storage);
 	} else {
 		stream.swscale = MakeSwscalePointer(
 			frame,
@@ -8,6 +8,7 @@ https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
 #include "mtproto/connection_tcp.h"
 
 #include "mtproto/details/mtproto_abstract_socket.h"
+#include "mtproto/details/mtproto_buffer_pool.h"
 #include "base/bytes.h"
 #include "base/openssl_help.h"
 #include "base/random.h"
@@ -403,7 +404,7 @@ mtpBuffer TcpConnection::parsePacket(bytes::const_span bytes) {
 		}
 		return mtpBuffer(1, ints[0]);
 	}
-	auto result = mtpBuffer(ints.size());
+	auto result = TakeBuffer(ints.size());
 	memcpy(result.data(), ints.data(), ints.size() * sizeof(mtpPrime));
 	return result;
 }
@@ -0,0 +1,135 @@
+/*
+This file is part of Telegram Desktop,
+the official desktop application for the Telegram messaging service.
+
+For license and copyright information please follow this link:
+https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
+*/
+#include "mtproto/details/mtproto_buffer_pool.h"
+
+#include <atomic>
+
+namespace MTP::details {
+namespace {
+
+constexpr auto kMaxPooledBytes = int64(4 * 1024 * 1024);
+constexpr auto kMaxPooledBufferSize = 1024 * 1024 / int(sizeof(mtpPrime));
+constexpr auto kPoolIdleTimeout = crl::time(10000);
+
+struct Counters {
+	std::atomic<int64> taken = 0;
+	std::atomic<int64> reused = 0;
+	std::atomic<int64> released = 0;
+	std::atomic<int64> dropped = 0;
+};
+
+struct Pool {
+	std::vector<mtpBuffer> buffers;
+	int64 bytes = 0;
+	crl::time lastUsed = 0;
+};
+
+Counters GlobalCounters;
+thread_local Pool ThreadPool;
+
+[[nodiscard]] int64 BufferBytes(const mtpBuffer &buffer) {
+	return int64(buffer.capacity()) * sizeof(mtpPrime);
+}
+
+void ClearPool(Pool &pool) {
+	GlobalCounters.dropped += int64(pool.buffers.size());
+	pool.buffers = std::vector<mtpBuffer>();
+	pool.bytes = 0;
+}
+
+// The session thread may stay alive for a long time without any traffic,
+// so the buffers left from a burst of downloads are freed on next use.
+void MarkUsed(Pool &pool) {
+	const auto now = crl::now();
+	if (pool.lastUsed && now - pool.lastUsed > kPoolIdleTimeout) {
+		ClearPool(pool);
+	}
+	pool.lastUsed = now;
+}
+
+} // namespace
+
+mtpBuffer TakeBuffer(int size) {
+	Expects(size >= 0);
+
+	++GlobalCounters.taken;
+
+	auto &pool = ThreadPool;
+	MarkUsed(pool);
+
+	// Take the smallest buffer that fits, the pool is tiny.
+	auto &buffers = pool.buffers;
+	auto best = end(buffers);
+	for (auto i = begin(buffers); i != end(buffers); ++i) {
+		if (i->capacity() >= size
+			&& (best == end(buffers) || i->capacity() < best->capacity())) {
+			best = i;
+		}
+	}
+	if (best == end(buffers)) {
+		return mtpBuffer(size);
+	}
+	++GlobalCounters.reused;
+	auto result = std::move(*best);
+	buffers.erase(best);
+	pool.bytes -= BufferBytes(result);
+	result.resize(size);
+	return result;
+}
+
+void ReleaseBuffer(mtpBuffer &&buffer) {
+	auto released = std::move(buffer);
+	const auto capacity = released.capacity();
+	if (!released.isDetached()
+		|| !capacity
+		|| capacity > kMaxPooledBufferSize) {
+		++GlobalCounters.dropped;
+		return;
+	}
+	auto &pool = ThreadPool;
+	MarkUsed(pool);
+
+	// Make room by dropping the smallest buffers, they are the cheapest
+	// to allocate again, but never drop a bigger one for a smaller one.
+	const auto bytes = BufferBytes(released);
+	auto &buffers = pool.buffers;
+	while (pool.bytes + bytes > kMaxPooledBytes) {
+		const auto smallest = ranges::min_element(
+			buffers,
+			ranges::less(),
+			[](const mtpBuffer &buffer) { return buffer.capacity(); });
+		if (smallest == end(buffers) || smallest->capacity() >= capacity) {
+			++GlobalCounters.dropped;
+			return;
+		}
+		pool.bytes -= BufferBytes(*smallest);
+		buffers.erase(smallest);
+		++GlobalCounters.dropped;
+	}
+	++GlobalCounters.released;
+	released.resize(0);
+	pool.bytes += bytes;
+	buffers.push_back(std::move(released));
+}
+
+void ClearBufferPool() {
+	auto &pool = ThreadPool;
+	ClearPool(pool);
+	pool.lastUsed = 0;
+}
+
+BufferPoolCounters CollectBufferPoolCounters() {
+	return {
+		.taken = GlobalCounters.taken.load(),
+		.reused = GlobalCounters.reused.load(),
+		.released = GlobalCounters.released.load(),
+		.dropped = GlobalCounters.dropped.load(),
+	};
+}
+
+} // namespace MTP::details
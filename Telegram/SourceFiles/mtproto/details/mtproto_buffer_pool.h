@@ -0,0 +1,34 @@
+/*
+This file is part of Telegram Desktop,
+the official desktop application for the Telegram messaging service.
+
+For license and copyright information please follow this link:
+https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
+*/
+#pragma once
+
+namespace MTP::details {
+
+struct BufferPoolCounters {
+	int64 taken = 0;
+	int64 reused = 0;
+	int64 released = 0;
+	int64 dropped = 0;
+};
+
+// Each thread has its own pool, so the buffers taken from it should be
+// released in the same thread, for example the received packets that are
+// decrypted and handled inside the session thread.
+//
+// The pool keeps at most a few megabytes per thread and frees them after
+// some seconds without use.
+[[nodiscard]] mtpBuffer TakeBuffer(int size);
+void ReleaseBuffer(mtpBuffer &&buffer);
+
+// Frees the buffers pooled in the current thread.
+void ClearBufferPool();
+
+// Summed up for all the threads, for profiling.
+[[nodiscard]] BufferPoolCounters CollectBufferPoolCounters();
+
+} // namespace MTP::details
@@ -9,9 +9,16 @@ https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
 
 #include "base/random.h"
 
+#include <zlib.h>
+
 namespace MTP::details {
 namespace {
 
+constexpr auto kCompressMinSize = 1024;
+
+// Don't bother sending gzip_packed if it saves less than 10%.
+constexpr auto kCompressMaxPercent = 90;
+
 uint32 CountPaddingPrimesCount(
 		uint32 requestSize,
 		bool forAuthKeyInner) {
@@ -33,6 +40,45 @@ uint32 CountPaddingPrimesCount(
 	return result + ((base::RandomValue<uchar>() & 0x0F) << 2);
 }
 
+[[nodiscard]] bool Compressible(mtpTypeId type) {
+	switch (type) {
+	case mtpc_upload_saveFilePart:
+	case mtpc_upload_saveBigFilePart:
+		return false; // Media is compressed already.
+	}
+	return true;
+}
+
+[[nodiscard]] QByteArray Gzip(bytes::const_span data) {
+	auto stream = z_stream();
+	const auto init = deflateInit2(
+		&stream,
+		Z_DEFAULT_COMPRESSION,
+		Z_DEFLATED,
+		16 + MAX_WBITS,
+		8,
+		Z_DEFAULT_STRATEGY);
+	if (init != Z_OK) {
+		return QByteArray();
+	}
+	auto result = QByteArray(
+		int(deflateBound(&stream, uLong(data.size()))),
+		Qt::Uninitialized);
+	stream.next_in = reinterpret_cast<Bytef*>(
+		const_cast<gsl::byte*>(data.data()));
+	stream.avail_in = uInt(data.size());
+	stream.next_out = reinterpret_cast<Bytef*>(result.data());
+	stream.avail_out = uInt(result.size());
+	const auto code = deflate(&stream, Z_FINISH);
+	const auto written = int(stream.total_out);
+	deflateEnd(&stream);
+	if (code != Z_STREAM_END) {
+		return QByteArray();
+	}
+	result.resize(written);
+	return result;
+}
+
 } // namespace
 
 SerializedRequest::SerializedRequest(const RequestConstructHider::Tag &tag)
@@ -130,6 +176,8 @@ bool SerializedRequest::needAck() const {
 
 	const auto type = mtpTypeId((*_data)[kMessageBodyPosition]);
 	switch (type) {
+	case mtpc_gzip_packed:
+		return true; // Only RPC queries are compressed.
 	case mtpc_msg_container:
 	case mtpc_msgs_ack:
 	case mtpc_http_wait:
@@ -143,6 +191,32 @@ bool SerializedRequest::needAck() const {
 	return true;
 }
 
+void SerializedRequest::tryCompress() {
+	Expects(_data != nullptr);
+	Expects(_data->size() > kMessageBodyPosition);
+
+	const auto size = sizeInBytes();
+	const auto type = mtpTypeId((*_data)[kMessageBodyPosition]);
+	if (size < kCompressMinSize || !Compressible(type)) {
+		return;
+	}
+	const auto packed = Gzip(bytes::make_span(*_data).subspan(
+		kMessageBodyPosition * sizeof(mtpPrime),
+		size));
+	if (packed.isEmpty()
+		|| packed.size() * 100 > int(size) * kCompressMaxPercent) {
+		return;
+	}
+	// gzip_packed is parsed manually, so it is not in the generated scheme.
+	const auto wrapped = MTP_bytes(packed);
+	const auto wrappedSize = sizeof(mtpPrime) + tl::count_length(wrapped);
+	_data->resize(kMessageBodyPosition);
+	_data->back() = mtpPrime(wrappedSize);
+	_data->push_back(mtpc_gzip_packed);
+	wrapped.write<mtpBuffer>(*_data);
+	_data->squeeze();
+}
+
 size_t SerializedRequest::sizeInBytes() const {
 	Expects(!_data || _data->size() > kMessageBodyPosition);
 	return _data ? (*_data)[kMessageLengthPosition] : 0;
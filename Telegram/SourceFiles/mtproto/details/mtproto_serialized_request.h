@@ -47,6 +47,13 @@ public:
 		typename = std::enable_if_t<tl::is_boxed_v<Request>>>
 		static SerializedRequest Serialize(const Request &request);
 
+	// RPC queries may be sent as gzip_packed, while the service messages
+	// (acks, resend and state requests) are always sent as is.
+	template <
+		typename Request,
+		typename = std::enable_if_t<tl::is_boxed_v<Request>>>
+		static SerializedRequest SerializeQuery(const Request &request);
+
 	// For template MTP requests and MTPBoxed instantiation.
 	template <typename Accumulator>
 	void write(Accumulator &to) const {
@@ -75,6 +82,9 @@ public:
 private:
 	explicit SerializedRequest(const RequestConstructHider::Tag &);
 
+	// Replaces a large request body with gzip_packed if it gets smaller.
+	void tryCompress();
+
 	[[nodiscard]] size_t sizeInBytes() const;
 	[[nodiscard]] const void *dataInBytes() const;
 
@@ -103,5 +113,12 @@ SerializedRequest SerializedRequest::Serialize(const Request &request) {
 	return serialized;
 }
 
+template <typename Request, typename>
+SerializedRequest SerializedRequest::SerializeQuery(const Request &request) {
+	auto serialized = Serialize(request);
+	serialized.tryCompress();
+	return serialized;
+}
+
 } // namespace details
 } // namespace MTP
@@ -697,7 +697,7 @@ void TlsSocket::readHello() {
 		if (!_socket.bytesAvailable()) {
 			return;
 		}
-		_incoming.append(_socket.readAll());
+		appendIncoming();
 	}
 	checkHelloParts12(parts1Size);
 }
@@ -785,7 +785,7 @@ void TlsSocket::readData() {
 	if (!isConnected()) {
 		return;
 	}
-	_incoming.append(_socket.readAll());
+	appendIncoming();
 	if (!checkNextPacket()) {
 		handleError();
 	} else if (hasBytesAvailable()) {
@@ -830,10 +830,23 @@ void TlsSocket::shiftIncomingBy(int amount) {
 		bytes::move(incoming, incoming.subspan(amount));
 		_incoming.chop(amount);
 	} else {
-		_incoming.clear();
+		// Keep the allocated capacity for the next packets.
+		_incoming.resize(0);
 	}
 }
 
+void TlsSocket::appendIncoming() {
+	// Read right into the incoming buffer without a temporary QByteArray.
+	const auto available = _socket.bytesAvailable();
+	if (available <= 0) {
+		return;
+	}
+	const auto was = _incoming.size();
+	_incoming.resize(was + available);
+	const auto read = _socket.read(_incoming.data() + was, available);
+	_incoming.resize(was + std::max(read, qint64(0)));
+}
+
 void TlsSocket::connectToHost(const QString &address, int port) {
 	Expects(_state == State::NotConnected);
 
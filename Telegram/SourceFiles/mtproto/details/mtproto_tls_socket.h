@@ -54,6 +54,7 @@ private:
 	void readData();
 	[[nodiscard]] bool checkNextPacket();
 	void shiftIncomingBy(int amount);
+	void appendIncoming();
 
 	const bytes::vector _secret;
 	QTcpSocket _socket;
@@ -137,6 +137,7 @@ public:
 		ResponseHandler &&callbacks);
 	SerializedRequest getRequest(mtpRequestId requestId);
 	[[nodiscard]] bool hasCallback(mtpRequestId requestId) const;
+	void parseCallbackResponse(Response &response) const;
 	void processCallback(const Response &response);
 	void processUpdate(const Response &message);
 
@@ -1142,6 +1143,25 @@ bool Instance::Private::hasCallback(mtpRequestId requestId) const {
 	return (it != _parserMap.cend());
 }
 
+void Instance::Private::parseCallbackResponse(Response &response) const {
+	if (response.reply.isEmpty() || response.reply[0] == mtpc_rpc_error) {
+		return;
+	}
+	auto parse = ParseHandler();
+	{
+		QMutexLocker locker(&_parserMapLock);
+		const auto it = _parserMap.find(response.requestId);
+		if (it == _parserMap.cend() || !it->second.parse) {
+			return;
+		}
+		parse = it->second.parse;
+	}
+
+	// If the parsing fails here the done handler will try it once again
+	// in the main thread and will report the error in a usual way.
+	response.parsed = parse(response.reply);
+}
+
 void Instance::Private::processCallback(const Response &response) {
 	const auto requestId = response.requestId;
 	ResponseHandler handler;
@@ -2069,6 +2089,10 @@ bool Instance::hasCallback(mtpRequestId requestId) const {
 	return _private->hasCallback(requestId);
 }
 
+void Instance::parseCallbackResponse(Response &response) const {
+	_private->parseCallbackResponse(response);
+}
+
 void Instance::processCallback(const Response &response) {
 	_private->processCallback(response);
 }
@@ -115,6 +115,7 @@ public:
 	void onSessionReset(ShiftedDcId shiftedDcId);
 
 	[[nodiscard]] bool hasCallback(mtpRequestId requestId) const;
+	void parseCallbackResponse(Response &response) const;
 	void processCallback(const Response &response);
 	void processUpdate(const Response &message);
 
@@ -161,7 +162,7 @@ public:
 			: details::GetNextRequestId();
 		sendSerialized(
 			requestId,
-			details::SerializedRequest::Serialize(request),
+			details::SerializedRequest::SerializeQuery(request),
 			std::move(callbacks),
 			shiftedDcId,
 			msCanWait,
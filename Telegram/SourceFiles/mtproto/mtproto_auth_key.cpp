@@ -12,6 +12,147 @@ https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
 #include <QtCore/QDataStream>
 
 namespace MTP {
+namespace {
+
+constexpr auto kBlockSize = 16;
+
+// Process the data by chunks so that the in-place calls work as well.
+constexpr auto kChunkSize = 256 * kBlockSize;
+
+// For small parts the context setup costs more than it saves.
+constexpr auto kMinEvpCtrSize = 16 * kBlockSize;
+constexpr auto kMinEvpIgeSize = 16 * kBlockSize;
+
+using CipherContext = std::unique_ptr<
+	EVP_CIPHER_CTX,
+	decltype(&EVP_CIPHER_CTX_free)>;
+
+// EVP ciphers choose AES-NI or ARMv8 crypto extensions in runtime,
+// while the legacy AES_* block functions always use the plain code.
+[[nodiscard]] CipherContext MakeContext(
+		const EVP_CIPHER *cipher,
+		const uchar *key,
+		const uchar *iv,
+		bool encrypt) {
+	auto result = CipherContext(EVP_CIPHER_CTX_new(), &EVP_CIPHER_CTX_free);
+	if (!result
+		|| EVP_CipherInit_ex(
+			result.get(),
+			cipher,
+			nullptr,
+			key,
+			iv,
+			encrypt ? 1 : 0) != 1) {
+		return CipherContext(nullptr, &EVP_CIPHER_CTX_free);
+	}
+	EVP_CIPHER_CTX_set_padding(result.get(), 0);
+	return result;
+}
+
+inline void XorBlock(uchar *to, const uchar *a, const uchar *b) {
+	for (auto i = 0; i != kBlockSize; ++i) {
+		to[i] = a[i] ^ b[i];
+	}
+}
+
+// Big endian 128 bit counter, the same as in CRYPTO_ctr128_encrypt.
+void IncrementCounter(uchar *counter, uint64 blocks) {
+	for (auto i = kBlockSize; i != 0 && blocks != 0;) {
+		--i;
+		const auto sum = uint64(counter[i]) + (blocks & 0xFF);
+		counter[i] = uchar(sum & 0xFF);
+		blocks = (blocks >> 8) + (sum >> 8);
+	}
+}
+
+// IGE encryption y[i] = E(x[i] ^ y[i - 1]) ^ x[i - 1] is the same as
+// CBC encryption of x[i] ^ x[i - 2] with the result xored by x[i - 1].
+[[nodiscard]] bool AesIgeEncryptEvp(
+		const uchar *from,
+		uchar *to,
+		uint32 len,
+		const uchar *key,
+		const uchar *iv) {
+	const auto context = MakeContext(EVP_aes_256_cbc(), key, iv, true);
+	if (!context) {
+		return false;
+	}
+	uchar plain[kChunkSize];
+	uchar mixed[kChunkSize];
+	uchar previous[kBlockSize] = { 0 };
+	uchar beforePrevious[kBlockSize] = { 0 };
+	uchar last[kBlockSize] = { 0 };
+	memcpy(previous, iv + kBlockSize, kBlockSize);
+	while (len > 0) {
+		const auto size = int(std::min(len, uint32(kChunkSize)));
+		memcpy(plain, from, size);
+		memcpy(last, previous, kBlockSize);
+		for (auto i = 0; i != size; i += kBlockSize) {
+			XorBlock(mixed + i, plain + i, beforePrevious);
+			memcpy(beforePrevious, previous, kBlockSize);
+			memcpy(previous, plain + i, kBlockSize);
+		}
+		auto written = 0;
+		if (EVP_EncryptUpdate(
+				context.get(),
+				mixed,
+				&written,
+				mixed,
+				size) != 1
+			|| written != size) {
+			return false;
+		}
+		XorBlock(to, mixed, last);
+		for (auto i = kBlockSize; i != size; i += kBlockSize) {
+			XorBlock(to + i, mixed + i, plain + i - kBlockSize);
+		}
+		from += size;
+		to += size;
+		len -= size;
+	}
+	return true;
+}
+
+// IGE decryption x[i] = D(y[i] ^ x[i - 1]) ^ y[i - 1] can't be reduced
+// to a chained EVP mode, but even the block by block EVP calls are much
+// faster than the plain AES_decrypt.
+[[nodiscard]] bool AesIgeDecryptEvp(
+		const uchar *from,
+		uchar *to,
+		uint32 len,
+		const uchar *key,
+		const uchar *iv) {
+	const auto context = MakeContext(EVP_aes_256_ecb(), key, nullptr, false);
+	if (!context) {
+		return false;
+	}
+	uchar previousEncrypted[kBlockSize] = { 0 };
+	uchar previousDecrypted[kBlockSize] = { 0 };
+	uchar encrypted[kBlockSize] = { 0 };
+	uchar block[kBlockSize] = { 0 };
+	memcpy(previousEncrypted, iv, kBlockSize);
+	memcpy(previousDecrypted, iv + kBlockSize, kBlockSize);
+	for (auto i = uint32(0); i != len; i += kBlockSize) {
+		memcpy(encrypted, from + i, kBlockSize);
+		XorBlock(block, encrypted, previousDecrypted);
+		auto written = 0;
+		if (EVP_DecryptUpdate(
+				context.get(),
+				block,
+				&written,
+				block,
+				kBlockSize) != 1
+			|| written != kBlockSize) {
+			return false;
+		}
+		XorBlock(to + i, block, previousEncrypted);
+		memcpy(previousEncrypted, encrypted, kBlockSize);
+		memcpy(previousDecrypted, to + i, kBlockSize);
+	}
+	return true;
+}
+
+} // namespace
 
 AuthKey::AuthKey(Type type, DcId dcId, const Data &data)
 : _type(type)
@@ -149,6 +290,17 @@ void AuthKey::countKeyId() {
 }
 
 void aesIgeEncryptRaw(const void *src, void *dst, uint32 len, const void *key, const void *iv) {
+	Expects(!(len % kBlockSize));
+
+	if (len >= kMinEvpIgeSize
+		&& AesIgeEncryptEvp(
+			static_cast<const uchar*>(src),
+			static_cast<uchar*>(dst),
+			len,
+			static_cast<const uchar*>(key),
+			static_cast<const uchar*>(iv))) {
+		return;
+	}
 	uchar aes_key[32], aes_iv[32];
 	memcpy(aes_key, key, 32);
 	memcpy(aes_iv, iv, 32);
@@ -159,6 +311,17 @@ void aesIgeEncryptRaw(const void *src, void *dst, uint32 len, const void *key, c
 }
 
 void aesIgeDecryptRaw(const void *src, void *dst, uint32 len, const void *key, const void *iv) {
+	Expects(!(len % kBlockSize));
+
+	if (len >= kMinEvpIgeSize
+		&& AesIgeDecryptEvp(
+			static_cast<const uchar*>(src),
+			static_cast<uchar*>(dst),
+			len,
+			static_cast<const uchar*>(key),
+			static_cast<const uchar*>(iv))) {
+		return;
+	}
 	uchar aes_key[32], aes_iv[32];
 	memcpy(aes_key, key, 32);
 	memcpy(aes_iv, iv, 32);
@@ -175,15 +338,50 @@ void aesCtrEncrypt(bytes::span data, const void *key, CTRState *state) {
 	static_assert(CTRState::IvecSize == AES_BLOCK_SIZE, "Wrong size of ctr ivec!");
 	static_assert(CTRState::EcountSize == AES_BLOCK_SIZE, "Wrong size of ctr ecount!");
 
-	CRYPTO_ctr128_encrypt(
-		reinterpret_cast<const uchar*>(data.data()),
-		reinterpret_cast<uchar*>(data.data()),
+	const auto process = [&](bytes::span part) {
+		CRYPTO_ctr128_encrypt(
+			reinterpret_cast<const uchar*>(part.data()),
+			reinterpret_cast<uchar*>(part.data()),
+			part.size(),
+			&aes,
+			state->ivec,
+			state->ecount,
+			&state->num,
+			(block128_f)AES_encrypt);
+	};
+
+	// Finish the started block with the saved ecount, then let EVP process
+	// the whole blocks and leave the tail with its ecount to the next call.
+	const auto head = std::min(
 		data.size(),
-		&aes,
+		std::size_t((kBlockSize - state->num) % kBlockSize));
+	const auto blocks = (data.size() - head) / kBlockSize;
+	const auto whole = blocks * kBlockSize;
+	if (whole < kMinEvpCtrSize) {
+		process(data);
+		return;
+	}
+	process(data.subspan(0, head));
+	const auto context = MakeContext(
+		EVP_aes_256_ctr(),
+		static_cast<const uchar*>(key),
 		state->ivec,
-		state->ecount,
-		&state->num,
-		(block128_f)AES_encrypt);
+		true);
+	const auto middle = data.subspan(head, whole);
+	auto written = 0;
+	if (!context
+		|| EVP_EncryptUpdate(
+			context.get(),
+			reinterpret_cast<uchar*>(middle.data()),
+			&written,
+			reinterpret_cast<const uchar*>(middle.data()),
+			int(middle.size())) != 1
+		|| written != int(middle.size())) {
+		process(data.subspan(head));
+		return;
+	}
+	IncrementCounter(state->ivec, blocks);
+	process(data.subspan(head + whole));
 }
 
 } // namespace MTP
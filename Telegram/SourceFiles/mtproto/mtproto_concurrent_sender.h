@@ -220,7 +220,9 @@ template <typename Request>
 ConcurrentSender::SpecificRequestBuilder<Request>::SpecificRequestBuilder(
 	not_null<ConcurrentSender*> sender,
 	Request &&request) noexcept
-: RequestBuilder(sender, details::SerializedRequest::Serialize(request)) {
+: RequestBuilder(
+	sender,
+	details::SerializedRequest::SerializeQuery(request)) {
 }
 
 template <typename Request>
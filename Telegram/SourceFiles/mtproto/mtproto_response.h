@@ -9,6 +9,8 @@ https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
 
 #include "base/flat_set.h"
 
+#include <any>
+
 class QDebug;
 
 namespace MTP {
@@ -61,14 +63,21 @@ struct Response {
 	mtpBuffer reply;
 	mtpMsgId outerMsgId = 0;
 	mtpRequestId requestId = 0;
+
+	// Typed reply, if it was already parsed in the session thread.
+	std::any parsed;
 };
 
 using DoneHandler = FnMut<bool(const Response&)>;
 using FailHandler = Fn<bool(const Error&, const Response&)>;
 
+// Called in the session thread, must not touch anything but the reply.
+using ParseHandler = Fn<std::any(const mtpBuffer&)>;
+
 struct ResponseHandler {
 	DoneHandler done;
 	FailHandler fail;
+	ParseHandler parse;
 };
 
 [[nodiscard]] QDebug operator<<(QDebug debug, const Error &error);
@@ -47,9 +47,13 @@ class Sender {
 
 				auto result = Result();
 				auto from = response.reply.constData();
-				if (!result.read(from, from + response.reply.size())) {
+				if (const auto parsed = std::any_cast<Result>(
+						&response.parsed)) {
+					result = *parsed;
+				} else if (!result.read(from, from + response.reply.size())) {
 					return false;
-				} else if (!onstack) {
+				}
+				if (!onstack) {
 					return true;
 				} else if constexpr (IsCallable<
 						Handler,
@@ -74,6 +78,17 @@ class Sender {
 			};
 		}
 
+		template <typename Result>
+		[[nodiscard]] static ParseHandler MakeParseHandler() {
+			return [](const mtpBuffer &reply) {
+				auto result = Result();
+				auto from = reply.constData();
+				return result.read(from, from + reply.size())
+					? std::any(std::move(result))
+					: std::any();
+			};
+		}
+
 		template <typename Handler>
 		[[nodiscard]] FailHandler MakeFailHandler(
 				not_null<Sender*> sender,
@@ -301,10 +316,15 @@ public:
 		}
 
 		mtpRequestId send() {
+			auto done = takeOnDone();
+			auto parse = done ? MakeParseHandler<Result>() : nullptr;
 			const auto id = sender()->_instance->send(
 				_request,
-				takeOnDone(),
-				takeOnFail(),
+				ResponseHandler{
+					.done = std::move(done),
+					.fail = takeOnFail(),
+					.parse = std::move(parse),
+				},
 				takeDcId(),
 				takeCanWait(),
 				takeAfter(),
@@ -9,6 +9,7 @@ https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
 #include "mtproto/session_private.h"
 
 #include "mtproto/details/mtproto_bound_key_creator.h"
+#include "mtproto/details/mtproto_buffer_pool.h"
 #include "mtproto/details/mtproto_dcenter.h"
 #include "mtproto/details/mtproto_dump_to_text.h"
 #include "mtproto/details/mtproto_rsa_public_key.h"
@@ -63,6 +64,9 @@ constexpr auto kAckSendWaiting = 10 * crl::time(1000);
 
 constexpr auto kCutContainerOnSize = 16 * 1024;
 
+// Deflate can't compress better than that.
+constexpr auto kMaxGzipRatio = 1032;
+
 auto SyncTimeRequestDuration = kFastRequestDuration;
 
 using namespace details;
@@ -99,6 +103,25 @@ using namespace details;
 	})();
 }
 
+[[nodiscard]] uint32 DeclaredGzipUnpackedSize(const QByteArray &packed) {
+	constexpr auto kMinGzipSize = 18; // 10 header + 8 trailer.
+	if (packed.size() < kMinGzipSize) {
+		return 0;
+	}
+	// The last four bytes are ISIZE, little endian.
+	const auto bytes = reinterpret_cast<const uchar*>(packed.constData())
+		+ packed.size()
+		- 4;
+	const auto result = uint32(bytes[0])
+		| (uint32(bytes[1]) << 8)
+		| (uint32(bytes[2]) << 16)
+		| (uint32(bytes[3]) << 24);
+	const auto valid = (result > 0)
+		&& !(result % sizeof(mtpPrime))
+		&& (uint64(result) <= uint64(packed.size()) * kMaxGzipRatio);
+	return valid ? result : 0;
+}
+
 void WrapInvokeAfter(
 		SerializedRequest &to,
 		const SerializedRequest &from,
@@ -187,6 +210,13 @@ SessionPrivate::~SessionPrivate() {
 
 	Expects(!_connection);
 	Expects(_testConnections.empty());
+
+	const auto counters = CollectBufferPoolCounters();
+	DEBUG_LOG(("MTP Info: buffers taken %1, reused %2, released %3, dropped %4."
+		).arg(counters.taken
+		).arg(counters.reused
+		).arg(counters.released
+		).arg(counters.dropped));
 }
 
 void SessionPrivate::appendTestConnection(
@@ -1258,6 +1288,7 @@ void SessionPrivate::connectingTimedOut() {
 
 void SessionPrivate::doDisconnect() {
 	destroyAllConnections();
+	ClearBufferPool();
 	setState(DisconnectedState);
 }
 
@@ -1297,12 +1328,12 @@ void SessionPrivate::handleReceived() {
 		auto encryptedInts = ints + kExternalHeaderIntsCount;
 		auto encryptedIntsCount = (intsCount - kExternalHeaderIntsCount) & ~0x03U;
 		auto encryptedBytesCount = encryptedIntsCount * kIntSize;
-		auto decryptedBuffer = QByteArray(encryptedBytesCount, Qt::Uninitialized);
+		auto decryptedBuffer = TakeBuffer(encryptedIntsCount);
 		auto msgKey = *(MTPint128*)(ints + 2);
 
 		aesIgeDecrypt(encryptedInts, decryptedBuffer.data(), encryptedBytesCount, _encryptionKey, msgKey);
 
-		auto decryptedInts = reinterpret_cast<const mtpPrime*>(decryptedBuffer.constData());
+		auto decryptedInts = decryptedBuffer.constData();
 		auto serverSalt = *(uint64*)&decryptedInts[0];
 		auto session = *(uint64*)&decryptedInts[2];
 		auto msgId = *(uint64*)&decryptedInts[4];
@@ -1440,6 +1471,9 @@ void SessionPrivate::handleReceived() {
 				_sessionData->queueNeedToResumeAndSend();
 			}
 		}
+
+		ReleaseBuffer(std::move(decryptedBuffer));
+		ReleaseBuffer(std::move(intsBuffer));
 	}
 	if (_connection->needHttpWait()) {
 		_sessionData->queueSendAnything();
@@ -1870,13 +1904,19 @@ SessionPrivate::HandleResult SessionPrivate::handleOneReceived(
 		}
 		const auto requestId = wasSent(requestMsgId);
 		if (requestId && requestId != mtpRequestId(0xFFFFFFFF)) {
-			// Save rpc_result for processing in the main thread.
-			QWriteLocker locker(_sessionData->haveReceivedMutex());
-			_sessionData->haveReceivedMessages().push_back({
+			auto received = Response{
 				.reply = std::move(response),
 				.outerMsgId = info.outerMsgId,
 				.requestId = requestId,
-			});
+			};
+
+			// Parse here, so that only the handlers run in the main thread.
+			_instance->parseCallbackResponse(received);
+
+			// Save rpc_result for processing in the main thread.
+			QWriteLocker locker(_sessionData->haveReceivedMutex());
+			_sessionData->haveReceivedMessages().push_back(
+				std::move(received));
 		} else {
 			DEBUG_LOG(("RPC Info: requestId not found for msgId %1").arg(requestMsgId));
 		}
@@ -2028,6 +2068,12 @@ mtpBuffer SessionPrivate::ungzip(const mtpPrime *from, const mtpPrime *end) cons
 	}
 	uint32 packedLen = packed.v.size(), unpackedChunk = packedLen;
 
+	// The gzip trailer declares the unpacked size, so usually we inflate
+	// right into the buffer of the exact size without any reallocations.
+	if (const auto declared = DeclaredGzipUnpackedSize(packed.v)) {
+		unpackedChunk = declared / sizeof(mtpPrime);
+	}
+
 	z_stream stream;
 	stream.zalloc = 0;
 	stream.zfree = 0;
@@ -2043,17 +2089,20 @@ mtpBuffer SessionPrivate::ungzip(const mtpPrime *from, const mtpPrime *end) cons
 	stream.next_in = reinterpret_cast<Bytef*>(packed.v.data());
 
 	stream.avail_out = 0;
-	while (!stream.avail_out) {
+	while (res != Z_STREAM_END && !stream.avail_out) {
 		result.resize(result.size() + unpackedChunk);
 		stream.avail_out = unpackedChunk * sizeof(mtpPrime);
 		stream.next_out = (Bytef*)&result[result.size() - unpackedChunk];
-		int res = inflate(&stream, Z_NO_FLUSH);
+		res = inflate(&stream, Z_NO_FLUSH);
 		if (res != Z_OK && res != Z_STREAM_END) {
 			inflateEnd(&stream);
 			LOG(("RPC Error: could not unpack gziped data, code: %1").arg(res));
 			DEBUG_LOG(("RPC Error: bad gzip: %1").arg(Logs::mb(packed.v.constData(), packedLen).str()));
 			return mtpBuffer();
 		}
+
+		// If the declared size was wrong grow geometrically.
+		unpackedChunk = std::max(unpackedChunk, uint32(result.size()));
 	}
 	if (stream.avail_out & 0x03) {
 		uint32 badSize = result.size() * sizeof(mtpPrime) - stream.avail_out;
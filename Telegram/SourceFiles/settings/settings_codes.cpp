@@ -10,6 +10,7 @@ https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
 #include "ui/toast/toast.h"
 #include "mainwidget.h"
 #include "mainwindow.h"
+#include "data/data_histories.h"
 #include "data/data_session.h"
 #include "data/data_cloud_themes.h"
 #include "history/history_item_components.h"
@@ -24,6 +25,7 @@ https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
 #include "mtproto/mtp_instance.h"
 #include "mtproto/mtproto_dc_options.h"
 #include "core/file_utilities.h"
+#include "core/startup_trace.h"
 #include "core/update_checker.h"
 #include "window/themes/window_theme.h"
 #include "window/themes/window_theme_editor.h"
@@ -256,6 +258,35 @@ auto GenerateCodes() {
 			});
 		});
 	});
+	codes.emplace(u"memoryusage"_q, [](SessionController *window) {
+		if (!window) {
+			return;
+		}
+		const auto usage = window->session().data().histories(
+		).collectMemoryUsage();
+		LOG(("Messages Memory: %1 histories, %2 items, %3 views, "
+			"%4 bytes in items, %5 bytes in texts."
+			).arg(usage.histories
+			).arg(usage.items
+			).arg(usage.views
+			).arg(usage.itemBytes
+			).arg(usage.textBytes));
+		for (const auto &[name, component] : usage.components) {
+			LOG(("Messages Memory: %1 - %2 items, %3 bytes."
+				).arg(name
+				).arg(component.count
+				).arg(component.bytes));
+		}
+		Ui::Toast::Show(u"%1 messages, %2 KB. See log.txt for details."_q
+			.arg(usage.items)
+			.arg((usage.itemBytes + usage.textBytes) / 1024));
+	});
+	codes.emplace(u"startuptrace"_q, [](SessionController *window) {
+		const auto path = cWorkingDir() + u"startup_trace.txt"_q;
+		if (Core::App().startupTrace().dump(path)) {
+			Ui::Toast::Show(u"Startup trace saved to %1"_q.arg(path));
+		}
+	});
 	codes.emplace(u"testchatcolors"_q, [](SessionController *window) {
 		const auto now = !Data::CloudThemes::TestingColors();
 		Data::CloudThemes::SetTestingColors(now);
@@ -13,6 +13,7 @@ https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
 #include "base/random.h"
 
 #include <crl/crl_object_on_thread.h>
+#include <crl/crl_semaphore.h>
 #include <QtCore/QtEndian>
 #include <QtCore/QSaveFile>
 
@@ -25,11 +26,18 @@ constexpr auto TdfMagicLen = int(sizeof(TdfMagic));
 
 constexpr auto kStrongIterationsCount = 100'000;
 
+enum class WriteMode : uchar {
+	Replace,
+	Append,
+	Remove,
+};
+
 struct WriteEntry {
 	QString basePath;
 	QString base;
 	QByteArray data;
 	QByteArray md5;
+	WriteMode mode = WriteMode::Replace;
 };
 
 class WriteManager final {
@@ -45,6 +53,7 @@ private:
 	void writeScheduled();
 	bool writeOneScheduledNow();
 	void writeNow(WriteEntry &&entry);
+	void appendNow(WriteEntry &&entry);
 
 	template <typename File>
 	[[nodiscard]] bool open(File &file, const WriteEntry &entry, char postfix);
@@ -77,7 +86,10 @@ WriteManager::WriteManager(crl::weak_on_thread<WriteManager> weak)
 }
 
 void WriteManager::write(WriteEntry &&entry) {
-	const auto i = ranges::find(_scheduled, entry.base, &WriteEntry::base);
+	// Journal operations are applied in the order they were requested.
+	const auto i = (entry.mode == WriteMode::Replace)
+		? ranges::find(_scheduled, entry.base, &WriteEntry::base)
+		: end(_scheduled);
 	if (i == end(_scheduled)) {
 		_scheduled.push_back(std::move(entry));
 	} else {
@@ -95,6 +107,9 @@ void WriteManager::writeSync(WriteEntry &&entry) {
 }
 
 void WriteManager::writeNow(WriteEntry &&entry) {
+	if (entry.mode != WriteMode::Replace) {
+		return appendNow(std::move(entry));
+	}
 	const auto path = [&](char postfix) {
 		return this->path(entry, postfix);
 	};
@@ -135,6 +150,25 @@ void WriteManager::writeNow(WriteEntry &&entry) {
 	}
 }
 
+void WriteManager::appendNow(WriteEntry &&entry) {
+	const auto path = entry.base;
+	if (entry.mode == WriteMode::Remove) {
+		QFile::remove(path);
+		return;
+	}
+	auto file = QFile(path);
+	if (!file.open(QIODevice::WriteOnly | QIODevice::Append)) {
+		LOG(("Storage Error: Could not open '%1' for appending.").arg(path));
+		return;
+	}
+	const auto was = file.size();
+	if (file.write(entry.data) != entry.data.size() || !file.flush()) {
+		// Don't leave a cut record, the next ones would be lost after it.
+		LOG(("Storage Error: Could not append to '%1'.").arg(path));
+		file.resize(was);
+	}
+}
+
 void WriteManager::writeSyncAll() {
 	while (writeOneScheduledNow()) {
 	}
@@ -236,6 +270,119 @@ void AsyncWriteManager::stop() {
 
 AsyncWriteManager Manager;
 
+struct RawFile {
+	QByteArray data;
+	int32 version = 0;
+};
+
+// Paths of the files read ahead, main thread only.
+base::flat_map<QString, std::optional<RawFile>> Preloaded;
+std::atomic<int64> BytesRead = 0;
+
+// Thread-safe, only the file system is accessed here.
+[[nodiscard]] std::optional<RawFile> ReadRawFile(
+		const QString &name,
+		const QString &basePath) {
+	const auto base = basePath + name;
+
+	// detect order of read attempts
+	QString toTry[2];
+	const auto modern = base + 's';
+	if (QFileInfo::exists(modern)) {
+		toTry[0] = modern;
+	} else {
+		// Legacy way.
+		toTry[0] = base + '0';
+		QFileInfo toTry0(toTry[0]);
+		if (toTry0.exists()) {
+			toTry[1] = basePath + name + '1';
+			QFileInfo toTry1(toTry[1]);
+			if (toTry1.exists()) {
+				QDateTime mod0 = toTry0.lastModified();
+				QDateTime mod1 = toTry1.lastModified();
+				if (mod0 < mod1) {
+					qSwap(toTry[0], toTry[1]);
+				}
+			} else {
+				toTry[1] = QString();
+			}
+		} else {
+			toTry[0][toTry[0].size() - 1] = '1';
+		}
+	}
+	for (int32 i = 0; i < 2; ++i) {
+		QString fname(toTry[i]);
+		if (fname.isEmpty()) break;
+
+		QFile f(fname);
+		if (!f.open(QIODevice::ReadOnly)) {
+			DEBUG_LOG(("App Info: failed to open '%1' for reading"
+				).arg(name));
+			continue;
+		}
+
+		// check magic
+		char magic[TdfMagicLen];
+		if (f.read(magic, TdfMagicLen) != TdfMagicLen) {
+			DEBUG_LOG(("App Info: failed to read magic from '%1'"
+				).arg(name));
+			continue;
+		}
+		if (memcmp(magic, TdfMagic, TdfMagicLen)) {
+			DEBUG_LOG(("App Info: bad magic %1 in '%2'").arg(
+				Logs::mb(magic, TdfMagicLen).str(),
+				name));
+			continue;
+		}
+
+		// read app version
+		qint32 version;
+		if (f.read((char*)&version, sizeof(version)) != sizeof(version)) {
+			DEBUG_LOG(("App Info: failed to read version from '%1'"
+				).arg(name));
+			continue;
+		}
+		if (version > AppVersion) {
+			DEBUG_LOG(("App Info: version too big %1 for '%2', my version %3"
+				).arg(version
+				).arg(name
+				).arg(AppVersion));
+			continue;
+		}
+
+		// read data
+		QByteArray bytes = f.read(f.size());
+		BytesRead += f.size();
+		int32 dataSize = bytes.size() - 16;
+		if (dataSize < 0) {
+			DEBUG_LOG(("App Info: bad file '%1', could not read sign part"
+				).arg(name));
+			continue;
+		}
+
+		// check signature
+		HashMd5 md5;
+		md5.feed(bytes.constData(), dataSize);
+		md5.feed(&dataSize, sizeof(dataSize));
+		md5.feed(&version, sizeof(version));
+		md5.feed(magic, TdfMagicLen);
+		if (memcmp(md5.result(), bytes.constData() + dataSize, 16)) {
+			DEBUG_LOG(("App Info: bad file '%1', signature did not match"
+				).arg(name));
+			continue;
+		}
+
+		bytes.resize(dataSize);
+
+		if ((i == 0 && !toTry[1].isEmpty()) || i == 1) {
+			QFile::remove(toTry[1 - i]);
+		}
+
+		return RawFile{ .data = std::move(bytes), .version = version };
+	}
+	return std::nullopt;
+}
+
 } // namespace
 
 QString ToFilePart(FileKey val) {
@@ -471,115 +618,121 @@ void FileWriteDescriptor::finish() {
 	return encrypted;
 }
 
-bool ReadFile(
-		FileReadDescriptor &result,
-		const QString &name,
-		const QString &basePath) {
-	const auto base = basePath + name;
-
-	// detect order of read attempts
-	QString toTry[2];
-	const auto modern = base + 's';
-	if (QFileInfo::exists(modern)) {
-		toTry[0] = modern;
-	} else {
-		// Legacy way.
-		toTry[0] = base + '0';
-		QFileInfo toTry0(toTry[0]);
-		if (toTry0.exists()) {
-			toTry[1] = basePath + name + '1';
-			QFileInfo toTry1(toTry[1]);
-			if (toTry1.exists()) {
-				QDateTime mod0 = toTry0.lastModified();
-				QDateTime mod1 = toTry1.lastModified();
-				if (mod0 < mod1) {
-					qSwap(toTry[0], toTry[1]);
-				}
-			} else {
-				toTry[1] = QString();
-			}
-		} else {
-			toTry[0][toTry[0].size() - 1] = '1';
-		}
-	}
-	for (int32 i = 0; i < 2; ++i) {
-		QString fname(toTry[i]);
-		if (fname.isEmpty()) break;
-
-		QFile f(fname);
-		if (!f.open(QIODevice::ReadOnly)) {
-			DEBUG_LOG(("App Info: failed to open '%1' for reading"
-				).arg(name));
-			continue;
-		}
+void AppendJournal(
+		const FileKey &fkey,
+		const QString &basePath,
+		EncryptedDescriptor &data,
+		const MTP::AuthKeyPtr &key) {
+	auto record = QByteArray();
+	{
+		auto stream = QDataStream(&record, QIODevice::WriteOnly);
+		stream.setVersion(QDataStream::Qt_5_1);
+		stream << PrepareEncrypted(data, key);
+	}
+	Manager.write({
+		.basePath = basePath,
+		.base = basePath + ToFilePart(fkey) + 'j',
+		.data = std::move(record),
+		.mode = WriteMode::Append,
+	});
+}
 
-		// check magic
-		char magic[TdfMagicLen];
-		if (f.read(magic, TdfMagicLen) != TdfMagicLen) {
-			DEBUG_LOG(("App Info: failed to read magic from '%1'"
-				).arg(name));
-			continue;
-		}
-		if (memcmp(magic, TdfMagic, TdfMagicLen)) {
-			DEBUG_LOG(("App Info: bad magic %1 in '%2'").arg(
-				Logs::mb(magic, TdfMagicLen).str(),
-				name));
-			continue;
-		}
+void ClearJournal(const FileKey &fkey, const QString &basePath) {
+	Manager.write({
+		.basePath = basePath,
+		.base = basePath + ToFilePart(fkey) + 'j',
+		.mode = WriteMode::Remove,
+	});
+}
 
-		// read app version
-		qint32 version;
-		if (f.read((char*)&version, sizeof(version)) != sizeof(version)) {
-			DEBUG_LOG(("App Info: failed to read version from '%1'"
-				).arg(name));
-			continue;
-		}
-		if (version > AppVersion) {
-			DEBUG_LOG(("App Info: version too big %1 for '%2', my version %3"
-				).arg(version
-				).arg(name
-				).arg(AppVersion));
-			continue;
-		}
+JournalReadResult ReadJournal(
+		const FileKey &fkey,
+		const QString &basePath,
+		const MTP::AuthKeyPtr &key,
+		Fn<void(EncryptedDescriptor &record)> apply) {
+	auto file = QFile(basePath + ToFilePart(fkey) + 'j');
+	if (!file.open(QIODevice::ReadOnly)) {
+		return {};
+	}
+	const auto bytes = file.readAll();
+	BytesRead += bytes.size();
 
-		// read data
-		QByteArray bytes = f.read(f.size());
-		int32 dataSize = bytes.size() - 16;
-		if (dataSize < 0) {
-			DEBUG_LOG(("App Info: bad file '%1', could not read sign part"
-				).arg(name));
-			continue;
+	auto stream = QDataStream(bytes);
+	stream.setVersion(QDataStream::Qt_5_1);
+	auto result = JournalReadResult();
+	while (!stream.atEnd()) {
+		auto encrypted = QByteArray();
+		stream >> encrypted;
+
+		// The last record may be cut by a crash while appending.
+		EncryptedDescriptor record;
+		if (stream.status() != QDataStream::Ok
+			|| !DecryptLocal(record, encrypted, key)) {
+			LOG(("App Error: bad journal record in '%1'."
+				).arg(file.fileName()));
+			result.corrupted = true;
+			break;
 		}
+		apply(record);
+		++result.records;
+	}
+	return result;
+}
 
-		// check signature
-		HashMd5 md5;
-		md5.feed(bytes.constData(), dataSize);
-		md5.feed(&dataSize, sizeof(dataSize));
-		md5.feed(&version, sizeof(version));
-		md5.feed(magic, TdfMagicLen);
-		if (memcmp(md5.result(), bytes.constData() + dataSize, 16)) {
-			DEBUG_LOG(("App Info: bad file '%1', signature did not match"
-				).arg(name));
-			continue;
-		}
+void PreloadFiles(const std::vector<QString> &paths) {
+	if (paths.empty()) {
+		return;
+	}
+	auto results = std::vector<std::optional<RawFile>>(paths.size());
+	auto semaphore = crl::semaphore();
+	auto left = std::atomic<int>(int(paths.size()));
+	for (auto i = 0, count = int(paths.size()); i != count; ++i) {
+		crl::async([&, i] {
+			const auto &path = paths[i];
+			const auto slash = path.lastIndexOf('/') + 1;
+			results[i] = ReadRawFile(path.mid(slash), path.mid(0, slash));
+			if (--left == 0) {
+				semaphore.release();
+			}
+		});
+	}
+	semaphore.acquire();
 
-		bytes.resize(dataSize);
-		result.data = bytes;
-		bytes = QByteArray();
+	for (auto i = 0, count = int(paths.size()); i != count; ++i) {
+		Preloaded.emplace(paths[i], std::move(results[i]));
+	}
+}
 
-		result.version = version;
-		result.buffer.setBuffer(&result.data);
-		result.buffer.open(QIODevice::ReadOnly);
-		result.stream.setDevice(&result.buffer);
-		result.stream.setVersion(QDataStream::Qt_5_1);
+void ForgetPreloadedFiles() {
+	Preloaded.clear();
+}
 
-		if ((i == 0 && !toTry[1].isEmpty()) || i == 1) {
-			QFile::remove(toTry[1 - i]);
-		}
+int64 FilesBytesRead() {
+	return BytesRead.load();
+}
 
-		return true;
+bool ReadFile(
+		FileReadDescriptor &result,
+		const QString &name,
+		const QString &basePath) {
+	auto raw = std::optional<RawFile>();
+	const auto i = Preloaded.find(basePath + name);
+	if (i != end(Preloaded)) {
+		raw = std::move(i->second);
+		Preloaded.erase(i);
+	} else {
+		raw = ReadRawFile(name, basePath);
 	}
-	return false;
+	if (!raw) {
+		return false;
+	}
+	result.data = std::move(raw->data);
+	result.version = raw->version;
+	result.buffer.setBuffer(&result.data);
+	result.buffer.open(QIODevice::ReadOnly);
+	result.stream.setDevice(&result.buffer);
+	result.stream.setVersion(QDataStream::Qt_5_1);
+	return true;
 }
 
 bool DecryptLocal(
@@ -84,6 +84,15 @@ private:
 
 };
 
+// Reads the files concurrently on worker threads and waits for them,
+// so that the following ReadFile() calls for these paths are served
+// from memory. Each preloaded file can be read only once this way.
+void PreloadFiles(const std::vector<QString> &paths);
+void ForgetPreloadedFiles();
+
+// Total amount of bytes read by ReadFile() and PreloadFiles().
+[[nodiscard]] int64 FilesBytesRead();
+
 bool ReadFile(
 	FileReadDescriptor &result,
 	const QString &name,
@@ -106,6 +115,28 @@ bool ReadEncryptedFile(
 	const QString &basePath,
 	const MTP::AuthKeyPtr &key);
 
+// Append-only log of encrypted records next to the key file, so that
+// small changes don't require rewriting the whole file. The owner should
+// compact it by writing the key file and clearing the journal.
+void AppendJournal(
+	const FileKey &fkey,
+	const QString &basePath,
+	EncryptedDescriptor &data,
+	const MTP::AuthKeyPtr &key);
+void ClearJournal(const FileKey &fkey, const QString &basePath);
+
+// Reading stops at a bad record, then the journal should be compacted,
+// because the records appended after it would never be read.
+struct JournalReadResult {
+	int records = 0;
+	bool corrupted = false;
+};
+[[nodiscard]] JournalReadResult ReadJournal(
+	const FileKey &fkey,
+	const QString &basePath,
+	const MTP::AuthKeyPtr &key,
+	Fn<void(EncryptedDescriptor &record)> apply);
+
 void Sync();
 void Finish();
 
@@ -32,6 +32,8 @@ constexpr auto kMaxTrackedSuccesses = kRetryAddSessionSuccesses
 constexpr auto kRemoveSessionAfterTimeouts = 4;
 constexpr auto kResetDownloadPrioritiesTimeout = crl::time(200);
 constexpr auto kBadRequestDurationThreshold = 8 * crl::time(1000);
+constexpr auto kMinRttExpiresIn = 10 * crl::time(1000);
+constexpr auto kWindowGainPercent = 200;
 
 // Each (session remove by timeouts) we wait for time:
 // kRetryAddSessionTimeout * max(removesCount, kMaxTrackedSessionRemoves)
@@ -110,7 +112,43 @@ void DownloadManagerMtproto::Queue::removeSession(int index) {
 }
 
 DownloadManagerMtproto::DcSessionBalanceData::DcSessionBalanceData()
-: maxWaitedAmount(kStartWaitedInSession) {
+: minWaitedAmount(kStartWaitedInSession)
+, maxWaitedAmount(kStartWaitedInSession) {
+}
+
+void DownloadManagerMtproto::DcSessionBalanceData::feedSample(
+		int size,
+		crl::time sent,
+		crl::time received) {
+	const auto rtt = std::max(received - sent, crl::time(1));
+	smoothedRtt = smoothedRtt ? ((7 * smoothedRtt + rtt) / 8) : rtt;
+	if (!minRtt
+		|| rtt <= minRtt
+		|| received - minRttWhen > kMinRttExpiresIn) {
+		minRtt = rtt;
+		minRttWhen = received;
+	}
+
+	// Requests in flight overlap, so measure the delivery rate
+	// from the previous delivery in this session, not from the send.
+	const auto interval = std::max(
+		received - std::max(lastReceived, sent),
+		crl::time(1));
+	lastReceived = received;
+	const auto rate = int64(size) * 1000 / interval;
+	bytesPerSecond = bytesPerSecond
+		? ((7 * bytesPerSecond + rate) / 8)
+		: rate;
+}
+
+int DownloadManagerMtproto::DcSessionBalanceData::estimatedWindow() const {
+	const auto product = bytesPerSecond * minRtt / 1000;
+	const auto window = product * kWindowGainPercent / 100;
+	const auto parts = (window + kDownloadPartSize - 1) / kDownloadPartSize;
+	return int(std::clamp(
+		parts * kDownloadPartSize,
+		int64(minWaitedAmount),
+		int64(kMaxWaitedInSession)));
 }
 
 DownloadManagerMtproto::DcBalanceData::DcBalanceData()
@@ -179,6 +217,11 @@ void DownloadManagerMtproto::checkSendNextAfterSuccess(MTP::DcId dcId) {
 
 bool DownloadManagerMtproto::trySendNextPart(MTP::DcId dcId, Queue &queue) {
 	auto &balanceData = _balanceData[dcId];
+	const auto onlyHighestPriority = (balanceData.totalRequested > 0);
+	const auto task = queue.nextTask(onlyHighestPriority);
+	if (!task) {
+		return false;
+	}
 	const auto &sessions = balanceData.sessions;
 	const auto bestIndex = [&] {
 		const auto proj = [](const DcSessionBalanceData &data) {
@@ -187,19 +230,18 @@ bool DownloadManagerMtproto::trySendNextPart(MTP::DcId dcId, Queue &queue) {
 				: kMaxWaitedInSession;
 		};
 		const auto j = ranges::min_element(sessions, ranges::less(), proj);
-		return (j->requested + kDownloadPartSize <= j->maxWaitedAmount)
+
+		// Large parts may not fit in the window, send them one by one.
+		return (!j->requested
+			|| j->requested + task->partSize() <= j->maxWaitedAmount)
 			? (j - begin(sessions))
 			: -1;
 	}();
 	if (bestIndex < 0) {
 		return false;
 	}
-	const auto onlyHighestPriority = (balanceData.totalRequested > 0);
-	if (const auto task = queue.nextTask(onlyHighestPriority)) {
-		task->loadPart(bestIndex);
-		return true;
-	}
-	return false;
+	task->loadPart(bestIndex);
+	return true;
 }
 
 int DownloadManagerMtproto::changeRequestedAmount(
@@ -229,6 +271,7 @@ int DownloadManagerMtproto::changeRequestedAmount(
 void DownloadManagerMtproto::requestSucceeded(
 		MTP::DcId dcId,
 		int index,
+		int requestSize,
 		int amountAtRequestStart,
 		crl::time timeAtRequestStart) {
 	using namespace rpl::mappers;
@@ -239,7 +282,8 @@ void DownloadManagerMtproto::requestSucceeded(
 	Assert(index < dc.sessions.size());
 	auto &data = dc.sessions[index];
 	const auto overloaded = (timeAtRequestStart <= dc.lastSessionRemove)
-		|| (amountAtRequestStart > data.maxWaitedAmount);
+		|| (amountAtRequestStart > data.maxWaitedAmount
+			&& amountAtRequestStart > requestSize);
 	const auto parts = amountAtRequestStart / kDownloadPartSize;
 	const auto duration = (crl::now() - timeAtRequestStart);
 	DEBUG_LOG(("Download (%1,%2) request done, duration: %3, parts: %4%5"
@@ -259,15 +303,21 @@ void DownloadManagerMtproto::requestSucceeded(
 		});
 		return;
 	}
-	if (amountAtRequestStart == data.maxWaitedAmount
-		&& data.maxWaitedAmount < kMaxWaitedInSession) {
-		data.maxWaitedAmount = std::min(
-			data.maxWaitedAmount + kDownloadPartSize,
-			kMaxWaitedInSession);
-		DEBUG_LOG(("Download (%1,%2) increased max waited amount %3."
+	data.feedSample(requestSize, timeAtRequestStart, crl::now());
+	if (data.minWaitedAmount < kStartWaitedInSession) {
+		data.minWaitedAmount += kDownloadPartSize;
+	}
+	const auto window = data.estimatedWindow();
+	if (window != data.maxWaitedAmount) {
+		data.maxWaitedAmount = window;
+		DEBUG_LOG(("Download (%1,%2) max waited amount %3, "
+			"rate: %4 B/s, rtt: %5 (min %6)."
 			).arg(dcId
 			).arg(index
-			).arg(data.maxWaitedAmount));
+			).arg(data.maxWaitedAmount
+			).arg(data.bytesPerSecond
+			).arg(data.smoothedRtt
+			).arg(data.minRtt));
 	}
 	data.successes = std::min(data.successes + 1, kMaxTrackedSuccesses);
 	const auto notEnough = ranges::any_of(
@@ -309,6 +359,29 @@ int DownloadManagerMtproto::chooseSessionIndex(MTP::DcId dcId) const {
 	return (j - begin(sessions));
 }
 
+auto DownloadManagerMtproto::sessionEstimates(MTP::DcId dcId) const
+-> std::vector<DownloadSessionEstimate> {
+	const auto i = _balanceData.find(dcId);
+	if (i == end(_balanceData)) {
+		return {};
+	}
+	const auto &sessions = i->second.sessions;
+	auto result = std::vector<DownloadSessionEstimate>();
+	result.reserve(sessions.size());
+	for (auto j = 0; j != int(sessions.size()); ++j) {
+		const auto &data = sessions[j];
+		result.push_back({
+			.index = j,
+			.requested = data.requested,
+			.window = data.maxWaitedAmount,
+			.bytesPerSecond = data.bytesPerSecond,
+			.smoothedRtt = data.smoothedRtt,
+			.minRtt = data.minRtt,
+		});
+	}
+	return result;
+}
+
 void DownloadManagerMtproto::sessionTimedOut(MTP::DcId dcId, int index) {
 	const auto i = _balanceData.find(dcId);
 	if (i == end(_balanceData)) {
@@ -322,6 +395,19 @@ void DownloadManagerMtproto::sessionTimedOut(MTP::DcId dcId, int index) {
 	for (auto &session : dc.sessions) {
 		session.successes = 0;
 	}
+
+	// Back off the timed out session first, remove it only if it repeats.
+	// The window floor is lowered as well, so that the next estimate
+	// doesn't return it right back and recovers by a part per success.
+	auto &timedOut = dc.sessions[index];
+	timedOut.minWaitedAmount = std::max(
+		timedOut.minWaitedAmount / 2,
+		kDownloadPartSize);
+	timedOut.maxWaitedAmount = std::max(
+		timedOut.maxWaitedAmount / 2,
+		timedOut.minWaitedAmount);
+	timedOut.bytesPerSecond /= 2;
+
 	if (dc.sessions.size() == kStartSessionsCount
 		|| ++dc.timeouts < kRemoveSessionAfterTimeouts) {
 		return;
@@ -454,6 +540,17 @@ const DownloadMtprotoTask::Location &DownloadMtprotoTask::location() const {
 	return _location;
 }
 
+int DownloadMtprotoTask::partSize() const {
+	return _partSize;
+}
+
+void DownloadMtprotoTask::setPartSize(int size) {
+	Expects(size > 0 && !(kDownloadLargePartSize % size));
+	Expects(!haveSentRequests());
+
+	_partSize = size;
+}
+
 void DownloadMtprotoTask::refreshFileReferenceFrom(
 		const Data::UpdatedFileReferences &updates,
 		int requestId,
@@ -512,7 +609,7 @@ void DownloadMtprotoTask::removeSession(int sessionIndex) {
 mtpRequestId DownloadMtprotoTask::sendRequest(
 		const RequestData &requestData) {
 	const auto offset = requestData.offset;
-	const auto limit = Storage::kDownloadPartSize;
+	const auto limit = _partSize;
 	const auto shiftedDcId = MTP::downloadDcId(
 		_cdnDcId ? _cdnDcId : dcId(),
 		requestData.sessionIndex);
@@ -603,13 +700,15 @@ void DownloadMtprotoTask::requestMoreCdnFileHashes() {
 		return;
 	}
 
-	const auto requestData = _cdnUncheckedParts.cbegin()->first;
+	const auto &[requestData, unchecked] = *_cdnUncheckedParts.cbegin();
 	const auto shiftedDcId = MTP::downloadDcId(
 		dcId(),
 		requestData.sessionIndex);
 	_cdnHashesRequestId = api().request(MTPupload_GetCdnFileHashes(
 		MTP_bytes(_cdnToken),
-		MTP_long(requestData.offset)
+		MTP_long(firstMissingCdnHashOffset(
+			requestData.offset,
+			unchecked.size()))
 	)).done([=](const MTPVector<MTPFileHash> &result, mtpRequestId id) {
 		getCdnFileHashesDone(result, id);
 	}).fail([=](const MTP::Error &error, mtpRequestId id) {
@@ -723,19 +822,44 @@ void DownloadMtprotoTask::cdnPartLoaded(const MTPupload_CdnFile &result, mtpRequ
 
 DownloadMtprotoTask::CheckCdnHashResult DownloadMtprotoTask::checkCdnFileHash(
 		int64 offset,
-		bytes::const_span buffer) {
-	const auto cdnFileHashIt = _cdnFileHashes.find(offset);
-	if (cdnFileHashIt == _cdnFileHashes.cend()) {
-		return CheckCdnHashResult::NoHash;
-	}
-	const auto realHash = openssl::Sha256(buffer);
-	const auto receivedHash = bytes::make_span(cdnFileHashIt->second.hash);
-	if (bytes::compare(realHash, receivedHash)) {
-		return CheckCdnHashResult::Invalid;
-	}
+		bytes::const_span buffer) const {
+	// A part may span several hashed chunks, each is checked separately.
+	do {
+		const auto cdnFileHashIt = _cdnFileHashes.find(offset);
+		if (cdnFileHashIt == _cdnFileHashes.cend()) {
+			return CheckCdnHashResult::NoHash;
+		}
+		const auto &[limit, hash] = cdnFileHashIt->second;
+		if (limit <= 0) {
+			return CheckCdnHashResult::Invalid;
+		}
+		const auto chunk = buffer.subspan(
+			0,
+			std::min(std::size_t(limit), buffer.size()));
+		const auto realHash = openssl::Sha256(chunk);
+		if (bytes::compare(realHash, bytes::make_span(hash))) {
+			return CheckCdnHashResult::Invalid;
+		}
+		offset += chunk.size();
+		buffer = buffer.subspan(chunk.size());
+	} while (!buffer.empty());
 	return CheckCdnHashResult::Good;
 }
 
+int64 DownloadMtprotoTask::firstMissingCdnHashOffset(
+		int64 offset,
+		int64 size) const {
+	const auto till = offset + size;
+	while (offset < till) {
+		const auto i = _cdnFileHashes.find(offset);
+		if (i == _cdnFileHashes.cend() || i->second.limit <= 0) {
+			return offset;
+		}
+		offset += i->second.limit;
+	}
+	return offset;
+}
+
 void DownloadMtprotoTask::reuploadDone(
 		const MTPVector<MTPFileHash> &result,
 		mtpRequestId requestId) {
@@ -754,7 +878,9 @@ void DownloadMtprotoTask::getCdnFileHashesDone(
 	const auto requestData = finishSentRequest(
 		requestId,
 		FinishRequestReason::Redirect);
+	const auto hashesWere = _cdnFileHashes.size();
 	addCdnHashes(result.v);
+	const auto someMoreHashes = (_cdnFileHashes.size() > hashesWere);
 	auto someMoreChecked = false;
 	for (auto i = _cdnUncheckedParts.begin(); i != _cdnUncheckedParts.cend();) {
 		const auto uncheckedData = i->first;
@@ -786,7 +912,7 @@ void DownloadMtprotoTask::getCdnFileHashesDone(
 		default: Unexpected("Result of checkCdnFileHash()");
 		}
 	}
-	if (!someMoreChecked) {
+	if (!someMoreChecked && !someMoreHashes) {
 		LOG(("API Error: "
 			"Could not find cdnFileHash for offset %1 "
 			"after getCdnFileHashes request."
@@ -807,7 +933,7 @@ void DownloadMtprotoTask::placeSentRequest(
 	const auto amount = _owner->changeRequestedAmount(
 		dcId(),
 		requestData.sessionIndex,
-		Storage::kDownloadPartSize);
+		_partSize);
 	const auto &[i, ok1] = _sentRequests.emplace(requestId, requestData);
 	const auto &[j, ok2] = _requestByOffset.emplace(
 		requestData.offset,
@@ -851,7 +977,7 @@ auto DownloadMtprotoTask::finishSentRequest(
 	_owner->changeRequestedAmount(
 		dcId(),
 		result.sessionIndex,
-		-Storage::kDownloadPartSize);
+		-_partSize);
 	_sentRequests.erase(it);
 	const auto ok = _requestByOffset.remove(result.offset);
 
@@ -863,6 +989,7 @@ auto DownloadMtprotoTask::finishSentRequest(
 		_owner->requestSucceeded(
 			dcId(),
 			result.sessionIndex,
+			_partSize,
 			result.requestedInSession,
 			result.sent);
 	}
@@ -19,14 +19,23 @@ class Error;
 
 namespace Storage {
 
-// Different part sizes are not supported for now :(
-// Because we start downloading with some part size
-// and then we get a CDN-redirect where we support only
-// fixed part size download for hash checking.
+// Default part size, all the partial cache and streaming code is aligned
+// to it. Large documents may be downloaded by bigger parts, up to the
+// server limit, CDN hashes are then checked for each chunk of the part.
 constexpr auto kDownloadPartSize = 128 * 1024;
+constexpr auto kDownloadLargePartSize = 1024 * 1024;
 
 class DownloadMtprotoTask;
 
+struct DownloadSessionEstimate {
+	int index = 0;
+	int requested = 0;
+	int window = 0;
+	int64 bytesPerSecond = 0;
+	crl::time smoothedRtt = 0;
+	crl::time minRtt = 0;
+};
+
 class DownloadManagerMtproto final : public base::has_weak_ptr {
 public:
 	using Task = DownloadMtprotoTask;
@@ -52,11 +61,16 @@ public:
 	void requestSucceeded(
 		MTP::DcId dcId,
 		int index,
+		int requestSize,
 		int amountAtRequestStart,
 		crl::time timeAtRequestStart);
 	void checkSendNextAfterSuccess(MTP::DcId dcId);
 	[[nodiscard]] int chooseSessionIndex(MTP::DcId dcId) const;
 
+	// Live estimates of the dc sessions, polled by the profiling code.
+	[[nodiscard]] std::vector<DownloadSessionEstimate> sessionEstimates(
+		MTP::DcId dcId) const;
+
 	void notifyNonPremiumDelay(DocumentId id) {
 		_nonPremiumDelays.fire_copy(id);
 	}
@@ -85,9 +99,20 @@ private:
 	struct DcSessionBalanceData {
 		DcSessionBalanceData();
 
+		void feedSample(int size, crl::time sent, crl::time received);
+		[[nodiscard]] int estimatedWindow() const;
+
 		int requested = 0;
 		int successes = 0; // Since last timeout in this dc in any session.
+		int minWaitedAmount = 0;
 		int maxWaitedAmount = 0;
+
+		// Congestion estimates, the window is the bandwidth-delay product.
+		int64 bytesPerSecond = 0;
+		crl::time smoothedRtt = 0;
+		crl::time minRtt = 0;
+		crl::time minRttWhen = 0;
+		crl::time lastReceived = 0;
 	};
 	struct DcBalanceData {
 		DcBalanceData();
@@ -153,6 +178,7 @@ public:
 	[[nodiscard]] Data::FileOrigin fileOrigin() const;
 	[[nodiscard]] uint64 objectId() const;
 	[[nodiscard]] const Location &location() const;
+	[[nodiscard]] int partSize() const;
 
 	[[nodiscard]] virtual bool readyToRequest() const = 0;
 	void loadPart(int sessionIndex);
@@ -172,6 +198,10 @@ protected:
 	void addToQueue(int priority = 0);
 	void removeFromQueue();
 
+	// Should be called before any request is sent.
+	// The size should divide kDownloadLargePartSize.
+	void setPartSize(int size);
+
 	[[nodiscard]] ApiWrap &api() const {
 		return _owner->api();
 	}
@@ -259,7 +289,10 @@ private:
 
 	[[nodiscard]] CheckCdnHashResult checkCdnFileHash(
 		int64 offset,
-		bytes::const_span buffer);
+		bytes::const_span buffer) const;
+	[[nodiscard]] int64 firstMissingCdnHashOffset(
+		int64 offset,
+		int64 size) const;
 
 	void subscribeToNonPremiumLimit();
 
@@ -269,6 +302,7 @@ private:
 	// _location can be changed with an updated file_reference.
 	Location _location;
 	const Data::FileOrigin _origin;
+	int _partSize = kDownloadPartSize;
 
 	base::flat_map<mtpRequestId, RequestData> _sentRequests;
 	base::flat_map<int64, mtpRequestId> _requestByOffset;
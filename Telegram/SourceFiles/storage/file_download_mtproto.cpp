@@ -16,6 +16,12 @@ https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
 #include "mtproto/mtproto_config.h"
 #include "mtproto/mtproto_auth_key.h"
 
+namespace {
+
+constexpr auto kLargePartsMinSize = 16 * int64(1024 * 1024);
+
+} // namespace
+
 mtpFileLoader::mtpFileLoader(
 	not_null<Main::Session*> session,
 	const StorageFileLocation &location,
@@ -138,7 +144,7 @@ int64 mtpFileLoader::takeNextRequestOffset() {
 	Expects(readyToRequest());
 
 	const auto result = _nextRequestOffset;
-	_nextRequestOffset += Storage::kDownloadPartSize;
+	_nextRequestOffset += partSize();
 	return result;
 }
 
@@ -181,20 +187,35 @@ bool mtpFileLoader::setWebFileSizeHook(int64 size) {
 }
 
 void mtpFileLoader::startLoading() {
+	choosePartSize();
 	addToQueue();
 }
 
 void mtpFileLoader::startLoadingWithPartial(const QByteArray &data) {
 	Expects(data.startsWith("partial:"));
 
+	choosePartSize();
+
 	constexpr auto kPrefix = 8;
-	const auto parts = (data.size() - kPrefix) / Storage::kDownloadPartSize;
-	const auto use = parts * int64(Storage::kDownloadPartSize);
+	const auto part = partSize();
+	const auto parts = (data.size() - kPrefix) / part;
+	const auto use = parts * int64(part);
 	if (use > 0) {
 		_nextRequestOffset = use;
 		feedPart(0, QByteArray::fromRawData(data.data() + kPrefix, use));
 	}
-	startLoading();
+	addToQueue();
+}
+
+void mtpFileLoader::choosePartSize() {
+	if (haveSentRequests() || _nextRequestOffset > 0) {
+		return;
+	}
+	const auto large = (_fullSize >= kLargePartsMinSize)
+		&& v::is<StorageFileLocation>(location().data);
+	setPartSize(large
+		? Storage::kDownloadLargePartSize
+		: Storage::kDownloadPartSize);
 }
 
 void mtpFileLoader::cancelHook() {
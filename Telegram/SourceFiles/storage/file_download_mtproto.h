@@ -68,6 +68,8 @@ private:
 	void cancelOnFail() override;
 	bool setWebFileSizeHook(int64 size) override;
 
+	void choosePartSize();
+
 	bool _lastComplete = false;
 	int64 _nextRequestOffset = 0;
 
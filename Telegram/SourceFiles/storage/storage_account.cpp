@@ -46,6 +46,7 @@ using namespace details;
 using Database = Cache::Database;
 
 constexpr auto kDelayedWriteTimeout = crl::time(1000);
+constexpr auto kMaxLocationsJournalRecords = 512;
 constexpr auto kWriteSearchSuggestionsDelay = 5 * crl::time(1000);
 constexpr auto kMaxSavedPlaybackPositions = 256;
 
@@ -224,6 +225,12 @@ std::unique_ptr<MTP::Config> Account::start(MTP::AuthKeyPtr localKey) {
 	return readMtpConfig();
 }
 
+void Account::appendStartFiles(std::vector<QString> &paths) const {
+	paths.push_back(_basePath + u"map"_q);
+	paths.push_back(_basePath + u"config"_q);
+	paths.push_back(BaseGlobalPath() + ToFilePart(_dataNameKey));
+}
+
 void Account::startAdded(MTP::AuthKeyPtr localKey) {
 	Expects(localKey != nullptr);
 
@@ -298,6 +305,9 @@ base::flat_set<QString> Account::collectGoodNames() const {
 	for (const auto &value : keys) {
 		push(value);
 	}
+	if (_locationsKey) {
+		result.emplace(ToFilePart(_locationsKey) + 'j');
+	}
 	return result;
 }
 
@@ -783,6 +793,9 @@ void Account::reset() {
 	_installedCustomEmojiKey = 0;
 	_featuredCustomEmojiKey = 0;
 	_archivedCustomEmojiKey = 0;
+	_installedMasksRead = _recentMasksRead = false;
+	_archivedStickersRead = _archivedMasksRead = false;
+	_savedGifsRead = false;
 	_legacyBackgroundKeyDay = _legacyBackgroundKeyNight = 0;
 	_settingsKey = _recentHashtagsAndBotsKey = _exportSettingsKey = 0;
 	_searchSuggestionsKey = 0;
@@ -793,6 +806,11 @@ void Account::reset() {
 	_fileLocations.clear();
 	_fileLocationPairs.clear();
 	_fileLocationAliases.clear();
+	_fileLocationsChanged.clear();
+	_fileLocationAliasesAdded.clear();
+	_locationsJournalRecords = 0;
+	_locationsGeneration = 0;
+	_locationsRewriteNeeded = false;
 	_downloadsSerialize = nullptr;
 	_downloadsSerialized = QByteArray();
 	_cacheTotalSizeLimit = Database::Settings().totalSizeLimit;
@@ -849,6 +867,17 @@ void Account::writeLocations() {
 	}
 	_locationsChanged = false;
 
+	if (_locationsKey
+		&& !_locationsRewriteNeeded
+		&& _locationsJournalRecords < kMaxLocationsJournalRecords) {
+		writeLocationsJournal();
+		return;
+	}
+	_locationsRewriteNeeded = false;
+	_locationsJournalRecords = 0;
+	_fileLocationsChanged.clear();
+	_fileLocationAliasesAdded.clear();
+
 	if (_downloadsSerialize) {
 		if (auto serialized = _downloadsSerialize()) {
 			_downloadsSerialized = std::move(*serialized);
@@ -857,6 +886,7 @@ void Account::writeLocations() {
 	if (_fileLocations.isEmpty() && _downloadsSerialized.isEmpty()) {
 		if (_locationsKey) {
 			ClearKey(_locationsKey, _basePath);
+			ClearJournal(_locationsKey, _basePath);
 			_locationsKey = 0;
 			writeMapDelayed();
 		}
@@ -892,6 +922,7 @@ void Account::writeLocations() {
 
 		size += sizeof(quint32); // legacy webLocationsCount
 		size += Serialize::bytearraySize(_downloadsSerialized);
+		size += sizeof(quint64); // journal generation
 
 		EncryptedDescriptor data(size);
 		auto legacyTypeField = 0;
@@ -914,11 +945,79 @@ void Account::writeLocations() {
 			data.stream << quint64(i.key().first) << quint64(i.key().second) << quint64(i.value().first) << quint64(i.value().second);
 		}
 
-		data.stream << quint32(0) << _downloadsSerialized;
+		// The journal records of the older generations are skipped, in case
+		// the journal wasn't cleared after this file was written.
+		++_locationsGeneration;
+		data.stream
+			<< quint32(0)
+			<< _downloadsSerialized
+			<< quint64(_locationsGeneration);
 
-		FileWriteDescriptor file(_locationsKey, _basePath);
-		file.writeEncrypted(data, _localKey);
+		{
+			FileWriteDescriptor file(_locationsKey, _basePath);
+			file.writeEncrypted(data, _localKey);
+		}
+		ClearJournal(_locationsKey, _basePath);
+	}
+}
+
+void Account::writeLocationsJournal() {
+	if (_fileLocationsChanged.empty() && _fileLocationAliasesAdded.empty()) {
+		return;
+	}
+	const auto valueSize = [](const Core::FileLocation &value) {
+		return Serialize::stringSize(value.name())
+			+ Serialize::bytearraySize(value.bookmark())
+			+ Serialize::dateTimeSize()
+			+ sizeof(quint32);
+	};
+	auto size = quint32(sizeof(quint64) + sizeof(quint32) * 2);
+	for (const auto &key : _fileLocationsChanged) {
+		size += sizeof(quint64) * 2 + sizeof(quint32);
+		for (auto i = _fileLocations.constFind(key)
+			; (i != _fileLocations.cend()) && (i.key() == key)
+			; ++i) {
+			size += valueSize(i.value());
+		}
 	}
+	size += _fileLocationAliasesAdded.size() * sizeof(quint64) * 4;
+
+	// Each record has the full list of locations for each changed key,
+	// so applying it doesn't depend on the previous state.
+	EncryptedDescriptor data(size);
+	data.stream
+		<< quint64(_locationsGeneration)
+		<< quint32(_fileLocationsChanged.size());
+	for (const auto &key : _fileLocationsChanged) {
+		const auto count = _fileLocations.count(key);
+		data.stream
+			<< quint64(key.first)
+			<< quint64(key.second)
+			<< quint32(count);
+		for (auto i = _fileLocations.constFind(key)
+			; (i != _fileLocations.cend()) && (i.key() == key)
+			; ++i) {
+			const auto &value = i.value();
+			data.stream
+				<< value.name()
+				<< value.bookmark()
+				<< value.modified
+				<< quint32(value.size);
+		}
+	}
+	data.stream << quint32(_fileLocationAliasesAdded.size());
+	for (const auto &[alias, key] : _fileLocationAliasesAdded) {
+		data.stream
+			<< quint64(alias.first)
+			<< quint64(alias.second)
+			<< quint64(key.first)
+			<< quint64(key.second);
+	}
+	AppendJournal(_locationsKey, _basePath, data, _localKey);
+
+	++_locationsJournalRecords;
+	_fileLocationsChanged.clear();
+	_fileLocationAliasesAdded.clear();
 }
 
 void Account::writeLocationsQueued() {
@@ -993,13 +1092,94 @@ void Account::readLocations() {
 			if (!locations.stream.atEnd()) {
 				locations.stream >> _downloadsSerialized;
 			}
+			if (!locations.stream.atEnd()) {
+				auto generation = quint64();
+				locations.stream >> generation;
+				_locationsGeneration = generation;
+			}
+		}
+	}
+
+	// Skipped or broken records are dropped by the next full write, the
+	// new records shouldn't be appended after them.
+	auto skipped = false;
+	const auto journal = ReadJournal(
+		_locationsKey,
+		_basePath,
+		_localKey,
+		[&](EncryptedDescriptor &record) {
+			if (!applyLocationsRecord(record.stream)) {
+				skipped = true;
+			}
+		});
+	_locationsJournalRecords = journal.records;
+	if (journal.corrupted || skipped) {
+		_locationsRewriteNeeded = true;
+	}
+}
+
+bool Account::applyLocationsRecord(QDataStream &stream) {
+	auto generation = quint64();
+	stream >> generation;
+	if (!CheckStreamStatus(stream) || generation != _locationsGeneration) {
+		return false;
+	}
+	auto count = quint32();
+	stream >> count;
+	for (auto i = quint32(); i != count; ++i) {
+		auto first = quint64(), second = quint64();
+		auto values = quint32();
+		stream >> first >> second >> values;
+		if (!CheckStreamStatus(stream)) {
+			return false;
+		}
+		const auto key = MediaKey(first, second);
+		for (auto j = _fileLocations.find(key)
+			; (j != _fileLocations.end()) && (j.key() == key)
+			;) {
+			const auto k = _fileLocationPairs.find(j.value().fname);
+			if (k != _fileLocationPairs.end() && k.value().first == key) {
+				_fileLocationPairs.erase(k);
+			}
+			j = _fileLocations.erase(j);
+		}
+		for (auto j = quint32(); j != values; ++j) {
+			auto loc = Core::FileLocation();
+			auto bookmark = QByteArray();
+			auto size = quint32();
+			stream >> loc.fname >> bookmark >> loc.modified >> size;
+			if (!CheckStreamStatus(stream)) {
+				return false;
+			}
+			loc.setBookmark(bookmark);
+			loc.size = int64(size);
+
+			_fileLocations.insert(key, loc);
+			if (!loc.inMediaCache()) {
+				_fileLocationPairs.insert(loc.fname, { key, loc });
+			}
+		}
+	}
+	auto aliases = quint32();
+	stream >> aliases;
+	for (auto i = quint32(); i != aliases; ++i) {
+		auto kfirst = quint64(), ksecond = quint64();
+		auto vfirst = quint64(), vsecond = quint64();
+		stream >> kfirst >> ksecond >> vfirst >> vsecond;
+		if (!CheckStreamStatus(stream)) {
+			return false;
 		}
+		_fileLocationAliases.insert(
+			MediaKey(kfirst, ksecond),
+			MediaKey(vfirst, vsecond));
 	}
+	return true;
 }
 
 void Account::updateDownloads(
 		Fn<std::optional<QByteArray>()> downloadsSerialize) {
 	_downloadsSerialize = std::move(downloadsSerialize);
+	_locationsRewriteNeeded = true;
 	writeLocationsDelayed();
 }
 
@@ -1764,6 +1944,7 @@ void Account::writeFileLocation(MediaKey location, const Core::FileLocation &loc
 			if (i.value().second == local) {
 				if (i.value().first != location) {
 					_fileLocationAliases.insert(location, i.value().first);
+					_fileLocationAliasesAdded[location] = i.value().first;
 					writeLocationsQueued();
 				}
 				return;
@@ -1775,6 +1956,7 @@ void Account::writeFileLocation(MediaKey location, const Core::FileLocation &loc
 						break;
 					}
 				}
+				_fileLocationsChanged.emplace(i.value().first);
 				_fileLocationPairs.erase(i);
 			}
 		}
@@ -1788,6 +1970,7 @@ void Account::writeFileLocation(MediaKey location, const Core::FileLocation &loc
 		}
 	}
 	_fileLocations.insert(location, local);
+	_fileLocationsChanged.emplace(location);
 	writeLocationsQueued();
 }
 
@@ -1799,6 +1982,7 @@ void Account::removeFileLocation(MediaKey location) {
 	while (i != _fileLocations.end() && (i.key() == location)) {
 		i = _fileLocations.erase(i);
 	}
+	_fileLocationsChanged.emplace(location);
 	writeLocationsQueued();
 }
 
@@ -1812,6 +1996,7 @@ Core::FileLocation Account::readFileLocation(MediaKey location) {
 		if (!i.value().inMediaCache() && !i.value().check()) {
 			_fileLocationPairs.remove(i.value().fname);
 			i = _fileLocations.erase(i);
+			_fileLocationsChanged.emplace(location);
 			writeLocationsDelayed();
 			continue;
 		}
@@ -2412,6 +2597,9 @@ void Account::writeArchivedStickers() {
 void Account::writeArchivedMasks() {
 	using SetFlag = Data::StickersSetFlag;
 
+	// Don't replace the stored sets with a list that misses them.
+	readArchivedMasks();
+
 	writeStickerSets(_archivedStickersKey, [](const Data::StickersSet &set) {
 		if (!(set.flags & SetFlag::Archived)
 			|| (set.type() != Data::StickersType::Masks)
@@ -2425,6 +2613,8 @@ void Account::writeArchivedMasks() {
 void Account::writeInstalledMasks() {
 	using SetFlag = Data::StickersSetFlag;
 
+	readInstalledMasks();
+
 	writeStickerSets(_installedMasksKey, [](const Data::StickersSet &set) {
 		if (!(set.flags & SetFlag::Installed)
 			|| (set.flags & SetFlag::Archived)
@@ -2437,6 +2627,8 @@ void Account::writeInstalledMasks() {
 }
 
 void Account::writeRecentMasks() {
+	// The set in memory replaces the stored one, even if it wasn't read.
+	_recentMasksRead = true;
 	writeStickerSets(_recentMasksKey, [](const Data::StickersSet &set) {
 		if (set.id != Data::Stickers::CloudRecentAttachedSetId
 			|| set.stickers.isEmpty()) {
@@ -2584,6 +2776,31 @@ void Account::importOldRecentStickers() {
 	writeMapDelayed();
 }
 
+void Account::readStartStickers() {
+	auto preload = std::vector<QString>();
+	for (const auto key : {
+		_installedStickersKey,
+		_installedCustomEmojiKey,
+		_featuredStickersKey,
+		_featuredCustomEmojiKey,
+		_recentStickersKey,
+		_favedStickersKey,
+	}) {
+		if (key) {
+			preload.push_back(_basePath + ToFilePart(key));
+		}
+	}
+	PreloadFiles(preload);
+	const auto guard = gsl::finally([] { ForgetPreloadedFiles(); });
+
+	readInstalledStickers();
+	readInstalledCustomEmoji();
+	readFeaturedStickers();
+	readFeaturedCustomEmoji();
+	readRecentStickers();
+	readFavedStickers();
+}
+
 void Account::readInstalledStickers() {
 	DEBUG_LOG(("Init: Read installed sticker sets."));
 
@@ -2637,6 +2854,10 @@ void Account::readRecentStickers() {
 void Account::readRecentMasks() {
 	DEBUG_LOG(("Init: Read recent masks."));
 
+	if (_recentMasksRead) {
+		return;
+	}
+	_recentMasksRead = true;
 	readStickerSets(_recentMasksKey);
 }
 
@@ -2649,32 +2870,34 @@ void Account::readFavedStickers() {
 void Account::readArchivedStickers() {
 	DEBUG_LOG(("Init: Read archived stickers."));
 
-	// TODO: refactor to support for multiple accounts.
-	static bool archivedStickersRead = false;
-	if (!archivedStickersRead) {
-		readStickerSets(
-			_archivedStickersKey,
-			&_owner->session().data().stickers().archivedSetsOrderRef());
-		archivedStickersRead = true;
+	if (_archivedStickersRead) {
+		return;
 	}
+	_archivedStickersRead = true;
+	readStickerSets(
+		_archivedStickersKey,
+		&_owner->session().data().stickers().archivedSetsOrderRef());
 }
 
 void Account::readArchivedMasks() {
 	DEBUG_LOG(("Init: Read archived masks."));
 
-	// TODO: refactor to support for multiple accounts.
-	static bool archivedMasksRead = false;
-	if (!archivedMasksRead) {
-		readStickerSets(
-			_archivedMasksKey,
-			&_owner->session().data().stickers().archivedMaskSetsOrderRef());
-		archivedMasksRead = true;
+	if (_archivedMasksRead) {
+		return;
 	}
+	_archivedMasksRead = true;
+	readStickerSets(
+		_archivedMasksKey,
+		&_owner->session().data().stickers().archivedMaskSetsOrderRef());
 }
 
 void Account::readInstalledMasks() {
 	DEBUG_LOG(("Init: Read installed masks."));
 
+	if (_installedMasksRead) {
+		return;
+	}
+	_installedMasksRead = true;
 	readStickerSets(
 		_installedMasksKey,
 		&_owner->session().data().stickers().maskSetsOrderRef(),
@@ -2721,6 +2944,10 @@ void Account::writeSavedGifs() {
 void Account::readSavedGifs() {
 	DEBUG_LOG(("Init: Read saved GIFs."));
 
+	if (_savedGifsRead) {
+		return;
+	}
+	_savedGifsRead = true;
 	if (!_savedGifsKey) {
 		return;
 	}
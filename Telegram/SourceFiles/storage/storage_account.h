@@ -72,6 +72,9 @@ public:
 	[[nodiscard]] std::unique_ptr<MTP::Config> start(
 		MTP::AuthKeyPtr localKey);
 	void startAdded(MTP::AuthKeyPtr localKey);
+
+	// Files that start() reads before the map is parsed.
+	void appendStartFiles(std::vector<QString> &paths) const;
 	[[nodiscard]] int oldMapVersion() const {
 		return _oldMapVersion;
 	}
@@ -126,6 +129,9 @@ public:
 	void writeFavedStickers();
 	void writeArchivedStickers();
 	void writeArchivedMasks();
+
+	// Masks, saved GIFs and archived sets are read on the first access.
+	void readStartStickers();
 	void readInstalledStickers();
 	void readFeaturedStickers();
 	void readRecentStickers();
@@ -247,7 +253,10 @@ private:
 	void writeMap();
 
 	void readLocations();
+	// Returns false if the record is from an older generation or broken.
+	[[nodiscard]] bool applyLocationsRecord(QDataStream &stream);
 	void writeLocations();
+	void writeLocationsJournal();
 	void writeLocationsQueued();
 	void writeLocationsDelayed();
 
@@ -331,6 +340,13 @@ private:
 	QMap<QString, QPair<MediaKey, Core::FileLocation>> _fileLocationPairs;
 	QMap<MediaKey, MediaKey> _fileLocationAliases;
 
+	// Changes since the last write, appended to the locations journal.
+	base::flat_set<MediaKey> _fileLocationsChanged;
+	base::flat_map<MediaKey, MediaKey> _fileLocationAliasesAdded;
+	int _locationsJournalRecords = 0;
+	quint64 _locationsGeneration = 0;
+	bool _locationsRewriteNeeded = false;
+
 	QByteArray _downloadsSerialized;
 	Fn<std::optional<QByteArray>()> _downloadsSerialize;
 
@@ -373,6 +389,11 @@ private:
 	bool _searchSuggestionsRead = false;
 	bool _inlineBotsDownloadsRead = false;
 	bool _mediaLastPlaybackPositionsRead = false;
+	bool _installedMasksRead = false;
+	bool _recentMasksRead = false;
+	bool _archivedStickersRead = false;
+	bool _archivedMasksRead = false;
+	bool _savedGifsRead = false;
 
 	std::vector<std::pair<DocumentId, crl::time>> _mediaLastPlaybackPosition;
 
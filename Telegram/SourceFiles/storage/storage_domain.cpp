@@ -167,9 +167,14 @@ Domain::StartModernResult Domain::startModern(
 
 	_oldVersion = keyData.version;
 
+	struct Prepared {
+		int index = 0;
+		std::unique_ptr<Main::Account> account;
+	};
 	auto tried = base::flat_set<int>();
-	auto sessions = base::flat_set<uint64>();
-	auto active = 0;
+	auto accounts = std::vector<Prepared>();
+	auto preload = std::vector<QString>();
+	accounts.reserve(count);
 	for (auto i = 0; i != count; ++i) {
 		auto index = qint32();
 		info.stream >> index;
@@ -180,21 +185,38 @@ Domain::StartModernResult Domain::startModern(
 				_owner,
 				_dataName,
 				index);
-			auto config = account->prepareToStart(_localKey);
-			const auto sessionId = account->willHaveSessionUniqueId(
-				config.get());
-			if (!sessions.contains(sessionId)
-				&& (sessionId != 0 || (sessions.empty() && i + 1 == count))) {
-				if (sessions.empty()) {
-					active = index;
-				}
-				account->start(std::move(config));
-				_owner->accountAddedInStorage({
-					.index = index,
-					.account = std::move(account)
-				});
-				sessions.emplace(sessionId);
+			account->local().appendStartFiles(preload);
+			accounts.push_back({ index, std::move(account) });
+		} else {
+			accounts.push_back({});
+		}
+	}
+
+	// Read all the accounts files at once, the parsing stays sequential.
+	PreloadFiles(preload);
+	const auto guard = gsl::finally([] { ForgetPreloadedFiles(); });
+
+	auto sessions = base::flat_set<uint64>();
+	auto active = 0;
+	for (auto i = 0; i != count; ++i) {
+		auto &[index, account] = accounts[i];
+		if (!account) {
+			continue;
+		}
+		auto config = account->prepareToStart(_localKey);
+		const auto sessionId = account->willHaveSessionUniqueId(
+			config.get());
+		if (!sessions.contains(sessionId)
+			&& (sessionId != 0 || (sessions.empty() && i + 1 == count))) {
+			if (sessions.empty()) {
+				active = index;
 			}
+			account->start(std::move(config));
+			_owner->accountAddedInStorage({
+				.index = index,
+				.account = std::move(account)
+			});
+			sessions.emplace(sessionId);
 		}
 	}
 	if (sessions.empty()) {
@@ -21,6 +21,8 @@ public:
 	void remove(SharedMediaRemoveAll &&query);
 	void invalidate(SharedMediaInvalidateBottom &&query);
 	void unload(SharedMediaUnloadThread &&query);
+	void startSharedMediaBatch();
+	void finishSharedMediaBatch();
 	rpl::producer<SharedMediaResult> query(SharedMediaQuery &&query) const;
 	SharedMediaResult snapshot(const SharedMediaQuery &query) const;
 	bool empty(const SharedMediaKey &key) const;
@@ -72,6 +74,14 @@ void Facade::Impl::unload(SharedMediaUnloadThread &&query) {
 	_sharedMedia.unload(std::move(query));
 }
 
+void Facade::Impl::startSharedMediaBatch() {
+	_sharedMedia.startBatch();
+}
+
+void Facade::Impl::finishSharedMediaBatch() {
+	_sharedMedia.finishBatch();
+}
+
 rpl::producer<SharedMediaResult> Facade::Impl::query(SharedMediaQuery &&query) const {
 	return _sharedMedia.query(std::move(query));
 }
@@ -163,6 +173,14 @@ void Facade::unload(SharedMediaUnloadThread &&query) {
 	_impl->unload(std::move(query));
 }
 
+void Facade::startSharedMediaBatch() {
+	_impl->startSharedMediaBatch();
+}
+
+void Facade::finishSharedMediaBatch() {
+	_impl->finishSharedMediaBatch();
+}
+
 rpl::producer<SharedMediaResult> Facade::query(SharedMediaQuery &&query) const {
 	return _impl->query(std::move(query));
 }
@@ -0,0 +1,110 @@
+/*
+This file is part of Telegram Desktop,
+the official desktop application for the Telegram messaging service.
+
+For license and copyright information please follow this link:
+https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
+*/
+#include "storage/storage_history_cache.h"
+
+#include "data/data_session.h"
+#include "main/main_session.h"
+#include "storage/cache/storage_cache_database.h"
+
+namespace Storage {
+namespace {
+
+constexpr auto kVersion = mtpPrime(1);
+
+[[nodiscard]] QByteArray Serialize(const MTPmessages_Messages &slice) {
+	auto messages = QVector<MTPMessage>();
+	auto chats = QVector<MTPChat>();
+	auto users = QVector<MTPUser>();
+	slice.match([](const MTPDmessages_messagesNotModified &) {
+	}, [&](const auto &data) {
+		messages = data.vmessages().v;
+		chats = data.vchats().v;
+		users = data.vusers().v;
+	});
+	if (messages.isEmpty()) {
+		return QByteArray();
+	}
+
+	// Topics and channel pts are not stored, they are always stale.
+	const auto stored = MTP_messages_messages(
+		MTP_vector<MTPMessage>(std::move(messages)),
+		MTP_vector<MTPForumTopic>(),
+		MTP_vector<MTPChat>(std::move(chats)),
+		MTP_vector<MTPUser>(std::move(users)));
+	auto buffer = mtpBuffer();
+	buffer.reserve(1 + (tl::count_length(stored) / sizeof(mtpPrime)));
+	buffer.push_back(kVersion);
+	stored.write(buffer);
+	return QByteArray(
+		reinterpret_cast<const char*>(buffer.constData()),
+		buffer.size() * sizeof(mtpPrime));
+}
+
+[[nodiscard]] std::optional<MTPmessages_Messages> Deserialize(
+		const QByteArray &serialized) {
+	if (serialized.size() <= sizeof(mtpPrime)
+		|| (serialized.size() % sizeof(mtpPrime)) != 0) {
+		return std::nullopt;
+	}
+	auto from = reinterpret_cast<const mtpPrime*>(serialized.constData());
+	const auto end = from + (serialized.size() / sizeof(mtpPrime));
+	if (*from++ != kVersion) {
+		return std::nullopt;
+	}
+	auto result = MTPmessages_Messages();
+	if (!result.read(from, end) || from != end) {
+		return std::nullopt;
+	}
+	return result;
+}
+
+} // namespace
+
+HistoryCache::HistoryCache(not_null<Main::Session*> session)
+: _session(session) {
+}
+
+void HistoryCache::put(
+		const Cache::Key &key,
+		const MTPmessages_Messages &slice) {
+	const auto weak = base::make_weak(_session);
+	crl::async([=] {
+		auto serialized = Serialize(slice);
+		crl::on_main(weak, [=, bytes = std::move(serialized)]() mutable {
+			if (bytes.isEmpty()) {
+				weak->data().cache().remove(key);
+			} else {
+				weak->data().cache().put(key, std::move(bytes));
+			}
+		});
+	});
+}
+
+void HistoryCache::get(
+		const Cache::Key &key,
+		Fn<void(MTPmessages_Messages&&)> done) {
+	const auto weak = base::make_weak(_session);
+	_session->data().cache().get(key, [=](QByteArray &&value) {
+		auto parsed = Deserialize(value);
+		if (!parsed) {
+			if (!value.isEmpty()) {
+				LOG(("History Cache Error: Could not read slice."));
+			}
+			return;
+		}
+		crl::on_main(weak, [=, slice = std::move(*parsed)]() mutable {
+			done(std::move(slice));
+		});
+	});
+}
+
+void HistoryCache::remove(const Cache::Key &key) {
+	_session->data().cache().remove(key);
+}
+
+} // namespace Storage
@@ -0,0 +1,37 @@
+/*
+This file is part of Telegram Desktop,
+the official desktop application for the Telegram messaging service.
+
+For license and copyright information please follow this link:
+https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
+*/
+#pragma once
+
+namespace Main {
+class Session;
+} // namespace Main
+
+namespace Storage {
+namespace Cache {
+struct Key;
+} // namespace Cache
+
+// Keeps the last server slice of each opened chat (or its shared media
+// list) in the encrypted session cache, so that it can be shown before
+// the first messages.getHistory or messages.search request finishes.
+class HistoryCache final {
+public:
+	explicit HistoryCache(not_null<Main::Session*> session);
+
+	void put(const Cache::Key &key, const MTPmessages_Messages &slice);
+	void get(
+		const Cache::Key &key,
+		Fn<void(MTPmessages_Messages&&)> done);
+	void remove(const Cache::Key &key);
+
+private:
+	const not_null<Main::Session*> _session;
+
+};
+
+} // namespace Storage
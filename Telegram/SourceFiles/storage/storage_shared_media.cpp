@@ -35,8 +35,38 @@ auto SharedMedia::enforceLists(Key key)
 	return result;
 }
 
+void SharedMedia::deferUpdatesInBatch(std::map<Key, Lists>::iterator i) {
+	if (!_batchDepth || !_batchLists.emplace(i->first).second) {
+		return;
+	}
+	for (auto &list : i->second) {
+		list.deferUpdates();
+	}
+}
+
+void SharedMedia::startBatch() {
+	++_batchDepth;
+}
+
+void SharedMedia::finishBatch() {
+	Expects(_batchDepth > 0);
+
+	if (--_batchDepth) {
+		return;
+	}
+	for (const auto &key : base::take(_batchLists)) {
+		const auto i = _lists.find(key);
+		if (i != end(_lists)) {
+			for (auto &list : i->second) {
+				list.sendDeferredUpdates();
+			}
+		}
+	}
+}
+
 void SharedMedia::add(SharedMediaAddNew &&query) {
 	const auto addByIt = [&](const auto i) {
+		deferUpdatesInBatch(i);
 		for (auto index = 0; index != kSharedMediaTypeCount; ++index) {
 			auto type = static_cast<SharedMediaType>(index);
 			if (query.types.test(type)) {
@@ -65,6 +95,7 @@ void SharedMedia::add(SharedMediaAddExisting &&query) {
 		query.topicRootId,
 		query.monoforumPeerId,
 	});
+	deferUpdatesInBatch(peerIt);
 	for (auto index = 0; index != kSharedMediaTypeCount; ++index) {
 		auto type = static_cast<SharedMediaType>(index);
 		if (query.types.test(type)) {
@@ -83,6 +114,7 @@ void SharedMedia::add(SharedMediaAddSlice &&query) {
 		query.topicRootId,
 		query.monoforumPeerId,
 	});
+	deferUpdatesInBatch(peerIt);
 	auto index = static_cast<int>(query.type);
 	peerIt->second[index].addSlice(
 		std::move(query.messageIds),
@@ -260,6 +260,11 @@ public:
 	void invalidate(SharedMediaInvalidateBottom &&query);
 	void unload(SharedMediaUnloadThread &&query);
 
+	// Slice updates of the lists changed between these calls are
+	// coalesced and sent once in finishBatch().
+	void startBatch();
+	void finishBatch();
+
 	rpl::producer<SharedMediaResult> query(SharedMediaQuery &&query) const;
 	SharedMediaResult snapshot(const SharedMediaQuery &query) const;
 	bool empty(const SharedMediaKey &key) const;
@@ -279,8 +284,11 @@ private:
 	using Lists = std::array<SparseIdsList, kSharedMediaTypeCount>;
 
 	std::map<Key, Lists>::iterator enforceLists(Key key);
+	void deferUpdatesInBatch(std::map<Key, Lists>::iterator i);
 
 	std::map<Key, Lists> _lists;
+	base::flat_set<Key> _batchLists;
+	int _batchDepth = 0;
 
 	rpl::event_stream<SharedMediaSliceUpdate> _sliceUpdated;
 	rpl::event_stream<SharedMediaRemoveOne> _oneRemoved;
@@ -126,6 +126,14 @@ void SparseIdsList::addRange(
 		accumulate_max(*_count, int(update.messages->size()));
 	}
 	update.count = _count;
+	if (_updatesDeferred) {
+		if (update.messages) {
+			_deferredRanges.push_back(update.range);
+		} else {
+			_countUpdateDeferred = true;
+		}
+		return;
+	}
 	_sliceUpdated.fire(std::move(update));
 }
 
@@ -229,6 +237,51 @@ rpl::producer<SparseIdsSliceUpdate> SparseIdsList::sliceUpdated() const {
 	return _sliceUpdated.events();
 }
 
+void SparseIdsList::deferUpdates() {
+	_updatesDeferred = true;
+}
+
+void SparseIdsList::sendDeferredUpdates() {
+	if (!base::take(_updatesDeferred)) {
+		return;
+	}
+	auto collected = base::take(_deferredRanges);
+	const auto countUpdated = base::take(_countUpdateDeferred);
+
+	// Join the overlapping ranges, they were merged into the same slice.
+	ranges::sort(collected, std::less<>(), &MsgRange::from);
+	auto joined = std::vector<MsgRange>();
+	joined.reserve(collected.size());
+	for (const auto &range : collected) {
+		if (!joined.empty() && joined.back().till >= range.from) {
+			accumulate_max(joined.back().till, range.till);
+		} else {
+			joined.push_back(range);
+		}
+	}
+	auto updates = std::vector<SparseIdsSliceUpdate>();
+	for (const auto &slice : _slices) {
+		const auto i = ranges::lower_bound(
+			joined,
+			slice.range.from,
+			std::less<>(),
+			&MsgRange::till);
+		if (i != end(joined) && i->from <= slice.range.till) {
+			updates.push_back({
+				.messages = &slice.messages,
+				.range = slice.range,
+				.count = _count,
+			});
+		}
+	}
+	if (updates.empty() && countUpdated) {
+		updates.push_back({ .count = _count });
+	}
+	for (auto &update : updates) {
+		_sliceUpdated.fire(std::move(update));
+	}
+}
+
 SparseIdsListResult SparseIdsList::queryFromSlice(
 		const SparseIdsListQuery &query,
 		const Slice &slice) const {
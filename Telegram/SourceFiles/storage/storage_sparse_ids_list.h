@@ -54,6 +54,11 @@ public:
 	SparseIdsListResult snapshot(const SparseIdsListQuery &query) const;
 	bool empty() const;
 
+	// The data is changed right away, but the slice updates are collected
+	// and sent once for each changed slice in sendDeferredUpdates().
+	void deferUpdates();
+	void sendDeferredUpdates();
+
 private:
 	struct Slice {
 		Slice(base::flat_set<MsgId> &&messages, MsgRange range);
@@ -99,6 +104,10 @@ private:
 	std::optional<int> _count;
 	base::flat_set<Slice> _slices;
 
+	std::vector<MsgRange> _deferredRanges;
+	bool _updatesDeferred = false;
+	bool _countUpdateDeferred = false;
+
 	rpl::event_stream<SparseIdsSliceUpdate> _sliceUpdated;
 
 };
@@ -88,6 +88,18 @@ QImage Image::original() const {
 	return _data;
 }
 
+int64 Image::memoryBytes() const {
+	auto result = int64(_data.sizeInBytes());
+	for (const auto &[key, pixmap] : _cache) {
+		result += int64(pixmap.width()) * pixmap.height() * 4;
+	}
+	return result;
+}
+
+void Image::forgetCache() const {
+	base::take(_cache);
+}
+
 const QPixmap &Image::cached(
 		int w,
 		int h,
@@ -36,6 +36,10 @@ public:
 
 	[[nodiscard]] QImage original() const;
 
+	// Decoded data together with all the prepared pixmaps.
+	[[nodiscard]] int64 memoryBytes() const;
+	void forgetCache() const;
+
 	[[nodiscard]] const QPixmap &pix(
 			QSize size,
 			const Images::PrepareArgs &args = {}) const {
@@ -15,6 +15,8 @@ PRIVATE
     ffmpeg/ffmpeg_bytes_io_wrap.h
     ffmpeg/ffmpeg_utility.cpp
     ffmpeg/ffmpeg_utility.h
+    ffmpeg/ffmpeg_yuv_convert.cpp
+    ffmpeg/ffmpeg_yuv_convert.h
 )
 
 target_include_directories(lib_ffmpeg
@@ -15,6 +15,8 @@ PRIVATE
     mtproto/details/mtproto_abstract_socket.h
     mtproto/details/mtproto_bound_key_creator.cpp
     mtproto/details/mtproto_bound_key_creator.h
+    mtproto/details/mtproto_buffer_pool.cpp
+    mtproto/details/mtproto_buffer_pool.h
     mtproto/details/mtproto_dc_key_binder.cpp
     mtproto/details/mtproto_dc_key_binder.h
     mtproto/details/mtproto_dc_key_creator.cpp